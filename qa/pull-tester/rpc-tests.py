@@ -124,6 +124,7 @@ testScripts = [
     'wallet-accounts.py',
     'wallet-dump.py',
     'listtransactions.py',
+    'storedocuments.py',
     'multikeysporks.py',
     # vv Tests less than 60s vv
     'sendheaders.py', # NOTE: needs dms_hash to pass
@@ -158,6 +159,7 @@ testScripts = [
     'keypool.py',
     'keypool-hd.py',
     'p2p-mempool.py',
+    'p2p-msghandlers.py',
     'prioritise_transaction.py',
     'invalidblockrequest.py', # NOTE: needs dms_hash to pass
     'invalidtxrequest.py', # NOTE: needs dms_hash to pass
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Documentchain developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test that the messages of one peer are answered in order while several
+# message handler threads process the messages of many peers. ping runs
+# concurrently, getheaders is serialized by cs_serialMessages.
+#
+
+from test_framework.mininode import *
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import *
+
+NUM_PEERS = 8
+NUM_ROUNDS = 100
+
+class TestNode(NodeConnCB):
+    def __init__(self):
+        NodeConnCB.__init__(self)
+        self.connection = None
+        self.responses = []
+
+    def add_connection(self, conn):
+        self.connection = conn
+
+    def send_message(self, message):
+        self.connection.send_message(message)
+
+    def on_pong(self, conn, message):
+        self.responses.append(("pong", message.nonce))
+
+    def on_headers(self, conn, message):
+        self.responses.append(("headers", len(message.headers)))
+
+class MessageHandlersTest(BitcoinTestFramework):
+    def __init__(self):
+        super().__init__()
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+
+    def setup_network(self):
+        # whitelisted peers get headers in initial block download
+        self.nodes = [start_node(0, self.options.tmpdir, ["-msghandlers=4", "-whitelist=127.0.0.1"])]
+
+    def run_test(self):
+        self.nodes[0].generate(10)
+        genesis = int(self.nodes[0].getblockhash(0), 16)
+
+        peers = []
+        for i in range(NUM_PEERS):
+            peer = TestNode()
+            peer.add_connection(NodeConn('127.0.0.1', p2p_port(0), self.nodes[0], peer))
+            peers.append(peer)
+        NetworkThread().start()
+        for peer in peers:
+            peer.wait_for_verack()
+
+        # all peers send at once, without waiting for the answers
+        getheaders = msg_getheaders()
+        getheaders.locator.vHave = [genesis]
+        for n in range(1, NUM_ROUNDS + 1):
+            for peer in peers:
+                peer.send_message(msg_ping(nonce=n))
+                peer.send_message(getheaders)
+
+        expected = []
+        for n in range(1, NUM_ROUNDS + 1):
+            expected += [("pong", n), ("headers", 10)]
+        for peer in peers:
+            assert(wait_until(lambda: len(peer.responses) >= len(expected), timeout=60))
+            with mininode_lock:
+                assert_equal(peer.responses, expected)
+
+if __name__ == '__main__':
+    MessageHandlersTest().main()
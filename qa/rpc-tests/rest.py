@@ -53,7 +53,7 @@ class RESTTest (BitcoinTestFramework):
         self.num_nodes = 3
 
     def setup_network(self, split=False):
-        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir)
+        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir, [["-documentindex"], [], []])
         connect_nodes_bi(self.nodes,0,1)
         connect_nodes_bi(self.nodes,1,2)
         connect_nodes_bi(self.nodes,0,2)
@@ -331,5 +331,33 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(json_string)
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        ####################
+        # /rest/document/ #
+        ####################
+
+        # a SHA3-256 file hash has the length of a SHA2-256 hash, it is found with or without the algorithm
+        sha3_hash = "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"
+        rawtx = self.nodes[0].createrawtransaction([], {"data": "444d2400020002" + "f032" + sha3_hash})
+        rawtx = self.nodes[0].fundrawtransaction(rawtx)['hex']
+        rawtx = self.nodes[0].signrawtransaction(rawtx)['hex']
+        doc_txid = self.nodes[0].sendrawtransaction(rawtx)
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        json_string = http_get_call(url.hostname, url.port, '/rest/document/'+sha3_hash+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['txid'], doc_txid)
+        assert_equal(json_obj['height'], self.nodes[0].getblockcount())
+        assert_equal(json_obj['confirmations'], 1)
+
+        json_string = http_get_call(url.hostname, url.port, '/rest/document/SHA3-256/'+sha3_hash+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['txid'], doc_txid)
+
+        response = http_get_call(url.hostname, url.port, '/rest/document/SHA2-256/'+sha3_hash+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/document/SHA3-224/'+sha3_hash+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 400)
+
 if __name__ == '__main__':
     RESTTest ().main ()
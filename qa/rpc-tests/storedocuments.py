@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Documentchain developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test the storedocuments RPC: one transaction per document, chained
+# through the change of the confirmed coins
+#
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import *
+
+import hashlib
+
+def document_payload(i):
+    # document revision with a SHA3-256 file hash
+    return "444d2400020002" + "f032" + hashlib.sha256(str(i).encode()).hexdigest()
+
+class StoreDocumentsTest(BitcoinTestFramework):
+    def __init__(self):
+        super().__init__()
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+
+    def setup_network(self):
+        # two documents per chain, so the coin count limits a batch
+        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir,
+                                 [["-limitancestorcount=2", "-limitdescendantcount=2"], []])
+        connect_nodes_bi(self.nodes, 0, 1)
+        self.is_network_split = False
+        self.sync_all()
+
+    def run_test(self):
+        node = self.nodes[0]
+        # ten mature coinbases
+        node.generate(110)
+        self.sync_all()
+
+        assert_raises_jsonrpc(-8, "No documents given", node.storedocuments, [])
+        assert_raises_jsonrpc(-8, "payloads[1] is not a valid document", node.storedocuments, [document_payload(0), "00"])
+        assert_raises_jsonrpc(-6, "Insufficient confirmed coins, 0 of 1 documents stored", self.nodes[1].storedocuments, [document_payload(0)])
+
+        payloads = [document_payload(i) for i in range(20)]
+        txids = node.storedocuments(payloads)
+        assert_equal(len(txids), len(payloads))
+        assert_equal(set(txids), set(node.getrawmempool()))
+
+        roots = 0
+        for txid, payload in zip(txids, payloads):
+            tx = node.getrawtransaction(txid, 1)
+            assert_equal(len(tx['vin']), 1)
+            assert_equal(tx['vout'][0]['scriptPubKey']['type'], 'nulldata')
+            assert(tx['vout'][0]['scriptPubKey']['hex'].endswith(payload))
+            if tx['vin'][0]['txid'] not in txids:
+                roots += 1
+        # every coin pays for one chain of two
+        assert_equal(roots, 10)
+
+        # the change is unconfirmed
+        assert_raises_jsonrpc(-6, "Insufficient confirmed coins", node.storedocuments, [document_payload(20)])
+
+        # one more mature coinbase next to the ten confirmed changes, the batch stops half way
+        node.generate(1)
+        self.sync_all()
+        payloads = [document_payload(i) for i in range(100, 125)]
+        assert_raises_jsonrpc(-4, "Insufficient confirmed coins, 22 of 25 documents stored", node.storedocuments, payloads)
+        assert_equal(len(node.getrawmempool()), 22)
+
+if __name__ == '__main__':
+    StoreDocumentsTest().main()
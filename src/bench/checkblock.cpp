@@ -5,6 +5,7 @@
 #include "bench.h"
 
 #include "chainparams.h"
+#include "hash.h"
 #include "validation.h"
 #include "streams.h"
 #include "consensus/validation.h"
@@ -50,5 +51,22 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// Cost of a memoized GetHash call, which happens several times for every accepted block
+// (the number of calls and yescrypt runs on the accept path is checked in headerhash_tests)
+static void BlockHashCached(benchmark::State& state)
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    block.GetHash();
+
+    while (state.KeepRunning()) {
+        block.GetHash();
+    }
+}
+
 BENCHMARK(DeserializeBlockTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(BlockHashCached);
@@ -0,0 +1,53 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "primitives/document.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "utilstrencodings.h"
+
+// DM$ version 2 with MD5 index hash, GUID, SHA2-256 file hash and SHA3-256 owner hash
+static const std::string DOCUMENT_V2 =
+    "444D2400020002"
+    "F000" "0F343B0931126A20F133D67C2B018A3B"
+    "0000" "8C25CFE61D4B4F5E9A0B3C4A41D2C6F1"
+    "F022" "2B5CB5CE6A1DDBFA8B4A52B42E7E0FB7AE1AD4B9D1B3CBD33C5B02C7F2FBD6A8"
+    "B032" "9F86D081884C7D659A2FEAA0C55AD015A3BF4F1B2B0B822CD15D6C15B0F00A08";
+
+// Document output followed by a P2PKH change output, as sent by the wallet
+static std::vector<CTxOut> DocumentOutputs()
+{
+    std::vector<CTxOut> vout;
+    vout.push_back(CTxOut(0, CScript() << OP_RETURN << ParseHex(DOCUMENT_V2)));
+    vout.push_back(CTxOut(100000, CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG));
+    return vout;
+}
+
+// Hex string round trip of the RPC and Qt code
+static void DocumentParseString(benchmark::State& state)
+{
+    const std::vector<CTxOut> vout = DocumentOutputs();
+    while (state.KeepRunning()) {
+        for (const CTxOut& txout : vout) {
+            CDocument document;
+            txout.GetDocument(document);
+        }
+    }
+}
+
+// In place parse of the document index
+static void DocumentParseRef(benchmark::State& state)
+{
+    const std::vector<CTxOut> vout = DocumentOutputs();
+    while (state.KeepRunning()) {
+        for (const CTxOut& txout : vout) {
+            CDocumentRef document;
+            txout.GetDocumentRef(document);
+        }
+    }
+}
+
+BENCHMARK(DocumentParseString);
+BENCHMARK(DocumentParseRef);
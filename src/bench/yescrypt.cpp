@@ -0,0 +1,124 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "hash.h"
+#include "headerhash.h"
+#include "primitives/block.h"
+
+#include <iostream>
+#include <thread>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+// yescrypt (N=4096, r=32) is the block header hash, each call needs a 16 MB scratch region
+// which is kept per thread. The peak RSS is printed after each case, it is the peak of the
+// whole process, so it only grows over the run and the order of the cases matters.
+
+/* Number of headers to hash per iteration in the thread scaling cases, enough to fill 8 threads */
+static const size_t SCALING_HEADERS = 128;
+
+static void PrintPeakRSS(const char* name)
+{
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        // kilobytes on Linux
+        std::cout << "#" << name << " peak RSS: " << usage.ru_maxrss << " kB\n";
+    }
+#endif
+}
+
+static std::vector<CBlockHeader> CreateHeaders(size_t count)
+{
+    std::vector<CBlockHeader> headers(count);
+    for (size_t i = 0; i < count; i++) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].nTime = 1546300800;
+        headers[i].nBits = 0x1e0ffff0;
+        headers[i].nNonce = i;
+    }
+    return headers;
+}
+
+static void YESCRYPT_0080b_single(benchmark::State& state)
+{
+    std::vector<char> in(80, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        yescrypt_hash(in.data(), (char*)hash.begin());
+        in[76]++;
+    }
+    PrintPeakRSS(__func__);
+}
+
+// first hash on a new thread, which has to set up its scratch region
+static void YESCRYPT_0080b_cold_thread(benchmark::State& state)
+{
+    std::vector<char> in(80, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        std::thread t([&in, &hash]() {
+            yescrypt_hash(in.data(), (char*)hash.begin());
+        });
+        t.join();
+    }
+    PrintPeakRSS(__func__);
+}
+
+// thread start and exit alone, to subtract from the cold thread case
+static void YESCRYPT_0080b_cold_thread_overhead(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        std::thread t([]() {});
+        t.join();
+    }
+}
+
+static void HashHeadersOnThreads(benchmark::State& state, int nThreads)
+{
+    std::vector<CBlockHeader> headers = CreateHeaders(SCALING_HEADERS);
+    // the calling thread hashes too
+    CHeaderHashWorker worker(nThreads - 1);
+    while (state.KeepRunning()) {
+        for (CBlockHeader& header : headers) {
+            header.nTime++;
+        }
+        worker.HashHeaders(headers);
+    }
+}
+
+static void YESCRYPT_headers_1_thread(benchmark::State& state)
+{
+    HashHeadersOnThreads(state, 1);
+    PrintPeakRSS(__func__);
+}
+
+static void YESCRYPT_headers_2_threads(benchmark::State& state)
+{
+    HashHeadersOnThreads(state, 2);
+    PrintPeakRSS(__func__);
+}
+
+static void YESCRYPT_headers_4_threads(benchmark::State& state)
+{
+    HashHeadersOnThreads(state, 4);
+    PrintPeakRSS(__func__);
+}
+
+static void YESCRYPT_headers_8_threads(benchmark::State& state)
+{
+    HashHeadersOnThreads(state, 8);
+    PrintPeakRSS(__func__);
+}
+
+BENCHMARK(YESCRYPT_0080b_single);
+BENCHMARK(YESCRYPT_0080b_cold_thread);
+BENCHMARK(YESCRYPT_0080b_cold_thread_overhead);
+BENCHMARK(YESCRYPT_headers_1_thread);
+BENCHMARK(YESCRYPT_headers_2_threads);
+BENCHMARK(YESCRYPT_headers_4_threads);
+BENCHMARK(YESCRYPT_headers_8_threads);
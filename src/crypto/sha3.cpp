@@ -0,0 +1,173 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/sha3.h"
+
+#include "crypto/common.h"
+
+#include <string.h>
+
+// Internal implementation code.
+namespace
+{
+/// Internal Keccak implementation.
+namespace keccak
+{
+const uint64_t RNDC[24] = {
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull, 0x8000000080008000ull,
+    0x000000000000808bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+    0x000000000000008aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+    0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull, 0x8000000000008003ull,
+    0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800aull, 0x800000008000000aull,
+    0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull};
+
+uint64_t inline Rotl(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+/** XOR a block of rate bytes into the state and permute it. */
+void inline Absorb(uint64_t (&s)[25], const unsigned char* data, size_t rate)
+{
+    for (size_t i = 0; i < rate / 8; i++)
+        s[i] ^= ReadLE64(data + 8 * i);
+    KeccakF(s);
+}
+
+} // namespace keccak
+
+} // namespace
+
+void KeccakF(uint64_t (&st)[25])
+{
+    uint64_t a00 = st[0], a01 = st[1], a02 = st[2], a03 = st[3], a04 = st[4];
+    uint64_t a05 = st[5], a06 = st[6], a07 = st[7], a08 = st[8], a09 = st[9];
+    uint64_t a10 = st[10], a11 = st[11], a12 = st[12], a13 = st[13], a14 = st[14];
+    uint64_t a15 = st[15], a16 = st[16], a17 = st[17], a18 = st[18], a19 = st[19];
+    uint64_t a20 = st[20], a21 = st[21], a22 = st[22], a23 = st[23], a24 = st[24];
+    uint64_t b00, b01, b02, b03, b04, b05, b06, b07, b08, b09, b10, b11, b12;
+    uint64_t b13, b14, b15, b16, b17, b18, b19, b20, b21, b22, b23, b24;
+    uint64_t c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        c0 = a00 ^ a05 ^ a10 ^ a15 ^ a20;
+        c1 = a01 ^ a06 ^ a11 ^ a16 ^ a21;
+        c2 = a02 ^ a07 ^ a12 ^ a17 ^ a22;
+        c3 = a03 ^ a08 ^ a13 ^ a18 ^ a23;
+        c4 = a04 ^ a09 ^ a14 ^ a19 ^ a24;
+        d0 = c4 ^ keccak::Rotl(c1, 1);
+        d1 = c0 ^ keccak::Rotl(c2, 1);
+        d2 = c1 ^ keccak::Rotl(c3, 1);
+        d3 = c2 ^ keccak::Rotl(c4, 1);
+        d4 = c3 ^ keccak::Rotl(c0, 1);
+
+        // Rho and pi
+        b00 = a00 ^ d0;
+        b16 = keccak::Rotl(a05 ^ d0, 36);
+        b07 = keccak::Rotl(a10 ^ d0, 3);
+        b23 = keccak::Rotl(a15 ^ d0, 41);
+        b14 = keccak::Rotl(a20 ^ d0, 18);
+        b10 = keccak::Rotl(a01 ^ d1, 1);
+        b01 = keccak::Rotl(a06 ^ d1, 44);
+        b17 = keccak::Rotl(a11 ^ d1, 10);
+        b08 = keccak::Rotl(a16 ^ d1, 45);
+        b24 = keccak::Rotl(a21 ^ d1, 2);
+        b20 = keccak::Rotl(a02 ^ d2, 62);
+        b11 = keccak::Rotl(a07 ^ d2, 6);
+        b02 = keccak::Rotl(a12 ^ d2, 43);
+        b18 = keccak::Rotl(a17 ^ d2, 15);
+        b09 = keccak::Rotl(a22 ^ d2, 61);
+        b05 = keccak::Rotl(a03 ^ d3, 28);
+        b21 = keccak::Rotl(a08 ^ d3, 55);
+        b12 = keccak::Rotl(a13 ^ d3, 25);
+        b03 = keccak::Rotl(a18 ^ d3, 21);
+        b19 = keccak::Rotl(a23 ^ d3, 56);
+        b15 = keccak::Rotl(a04 ^ d4, 27);
+        b06 = keccak::Rotl(a09 ^ d4, 20);
+        b22 = keccak::Rotl(a14 ^ d4, 39);
+        b13 = keccak::Rotl(a19 ^ d4, 8);
+        b04 = keccak::Rotl(a24 ^ d4, 14);
+
+        // Chi and iota
+        a00 = b00 ^ (~b01 & b02);
+        a01 = b01 ^ (~b02 & b03);
+        a02 = b02 ^ (~b03 & b04);
+        a03 = b03 ^ (~b04 & b00);
+        a04 = b04 ^ (~b00 & b01);
+        a05 = b05 ^ (~b06 & b07);
+        a06 = b06 ^ (~b07 & b08);
+        a07 = b07 ^ (~b08 & b09);
+        a08 = b08 ^ (~b09 & b05);
+        a09 = b09 ^ (~b05 & b06);
+        a10 = b10 ^ (~b11 & b12);
+        a11 = b11 ^ (~b12 & b13);
+        a12 = b12 ^ (~b13 & b14);
+        a13 = b13 ^ (~b14 & b10);
+        a14 = b14 ^ (~b10 & b11);
+        a15 = b15 ^ (~b16 & b17);
+        a16 = b16 ^ (~b17 & b18);
+        a17 = b17 ^ (~b18 & b19);
+        a18 = b18 ^ (~b19 & b15);
+        a19 = b19 ^ (~b15 & b16);
+        a20 = b20 ^ (~b21 & b22);
+        a21 = b21 ^ (~b22 & b23);
+        a22 = b22 ^ (~b23 & b24);
+        a23 = b23 ^ (~b24 & b20);
+        a24 = b24 ^ (~b20 & b21);
+        a00 ^= keccak::RNDC[round];
+    }
+
+    st[0] = a00; st[1] = a01; st[2] = a02; st[3] = a03; st[4] = a04;
+    st[5] = a05; st[6] = a06; st[7] = a07; st[8] = a08; st[9] = a09;
+    st[10] = a10; st[11] = a11; st[12] = a12; st[13] = a13; st[14] = a14;
+    st[15] = a15; st[16] = a16; st[17] = a17; st[18] = a18; st[19] = a19;
+    st[20] = a20; st[21] = a21; st[22] = a22; st[23] = a23; st[24] = a24;
+}
+
+CSHA3::CSHA3(size_t nOutputSize) : rate(200 - 2 * nOutputSize), bufsize(0), outputsize(nOutputSize)
+{
+    memset(s, 0, sizeof(s));
+}
+
+CSHA3& CSHA3::Write(const unsigned char* data, size_t len)
+{
+    const unsigned char* end = data + len;
+    if (bufsize && bufsize + len >= rate) {
+        // Fill the buffer, and process it.
+        memcpy(buf + bufsize, data, rate - bufsize);
+        data += rate - bufsize;
+        keccak::Absorb(s, buf, rate);
+        bufsize = 0;
+    }
+    while ((size_t)(end - data) >= rate) {
+        // Process full blocks directly from the source.
+        keccak::Absorb(s, data, rate);
+        data += rate;
+    }
+    if (end > data) {
+        // Fill the buffer with what remains.
+        memcpy(buf + bufsize, data, end - data);
+        bufsize += end - data;
+    }
+    return *this;
+}
+
+void CSHA3::Finalize(unsigned char* hash)
+{
+    // SHA-3 domain separation bits 01, then pad10*1
+    memset(buf + bufsize, 0, rate - bufsize);
+    buf[bufsize] ^= 0x06;
+    buf[rate - 1] ^= 0x80;
+    keccak::Absorb(s, buf, rate);
+
+    // every output size is shorter than the rate, one squeeze is enough
+    unsigned char out[200];
+    for (int i = 0; i < 25; i++)
+        WriteLE64(out + 8 * i, s[i]);
+    memcpy(hash, out, outputsize);
+}
+
+CSHA3& CSHA3::Reset()
+{
+    memset(s, 0, sizeof(s));
+    bufsize = 0;
+    return *this;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_SHA3_H
+#define BITCOIN_CRYPTO_SHA3_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** The Keccak-f[1600] permutation. */
+void KeccakF(uint64_t (&st)[25]);
+
+/** A hasher class for SHA3-224, SHA3-256, SHA3-384 and SHA3-512 (FIPS 202). */
+class CSHA3
+{
+private:
+    uint64_t s[25];
+    unsigned char buf[144];
+    size_t rate;
+    size_t bufsize;
+    size_t outputsize;
+
+public:
+    static const size_t MAX_OUTPUT_SIZE = 64;
+
+    /** nOutputSize is 28, 32, 48 or 64 bytes */
+    explicit CSHA3(size_t nOutputSize);
+    CSHA3& Write(const unsigned char* data, size_t len);
+    void Finalize(unsigned char* hash);
+    CSHA3& Reset();
+    size_t OutputSize() const { return outputsize; }
+};
+
+#endif // BITCOIN_CRYPTO_SHA3_H
@@ -17,89 +17,132 @@
  * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#if defined(HAVE_CONFIG_H)
+#include "config/dms-config.h"
+#endif
+
 #include "yescrypt.h"
 #include "sha256_c.h"
 #include "yescrypt-best_c.h"
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #define YESCRYPT_N 4096
 #define YESCRYPT_R 32
 #define YESCRYPT_P 1
 #define YESCRYPT_T 0
 #define YESCRYPT_FLAGS (YESCRYPT_RW | YESCRYPT_PWXFORM)
 
-#ifdef __clang__
-
-static int yescrypt_wavi(const uint8_t *passwd, size_t passwdlen,
-                            const uint8_t *salt, size_t saltlen,
-                            uint8_t *buf, size_t buflen)
-{
+/*
+ * Each hash needs a ~16 MB "local" scratch region. It is allocated on the first
+ * hash of a thread and then reused, so that hashing does not map and fault in a
+ * new region every time. The region is released when the thread exits.
+ */
+typedef struct {
     yescrypt_shared_t shared;
     yescrypt_local_t local;
-    int retval;
-    
-    if (yescrypt_init_shared(&shared, NULL, 0,
+} yescrypt_thread_ctx_t;
+
+static int yescrypt_init_thread_ctx(yescrypt_thread_ctx_t *ctx)
+{
+    /* "shared" could in fact be shared, but it's simpler to keep it private
+     * along with "local".  It's dummy and tiny anyway. */
+    if (yescrypt_init_shared(&ctx->shared, NULL, 0,
                              0, 0, 0, YESCRYPT_SHARED_DEFAULTS, 0, NULL, 0))
         return -1;
-    if (yescrypt_init_local(&local)) {
-        yescrypt_free_shared(&shared);
+    if (yescrypt_init_local(&ctx->local)) {
+        yescrypt_free_shared(&ctx->shared);
         return -1;
     }
-    retval = yescrypt_kdf(&shared, &local, passwd, passwdlen, salt, saltlen,
-                          YESCRYPT_N, YESCRYPT_R, YESCRYPT_P, YESCRYPT_T,
-                          YESCRYPT_FLAGS, buf, buflen);
-    if (yescrypt_free_local(&local)) {
-        yescrypt_free_shared(&shared);
-        return -1;
+    return 0;
+}
+
+static void yescrypt_free_thread_ctx(yescrypt_thread_ctx_t *ctx)
+{
+    yescrypt_free_local(&ctx->local);
+    yescrypt_free_shared(&ctx->shared);
+}
+
+#ifndef _WIN32
+
+/* pthread keys work with gcc and clang alike and run a destructor at thread exit */
+static pthread_key_t thread_ctx_key;
+static pthread_once_t thread_ctx_key_once = PTHREAD_ONCE_INIT;
+static int thread_ctx_key_created = 0;
+
+static void yescrypt_destroy_thread_ctx(void *p)
+{
+    yescrypt_free_thread_ctx((yescrypt_thread_ctx_t *)p);
+    free(p);
+}
+
+static void yescrypt_create_thread_ctx_key(void)
+{
+    thread_ctx_key_created = !pthread_key_create(&thread_ctx_key, yescrypt_destroy_thread_ctx);
+}
+
+static yescrypt_thread_ctx_t *yescrypt_get_thread_ctx(void)
+{
+    yescrypt_thread_ctx_t *ctx;
+
+    if (pthread_once(&thread_ctx_key_once, yescrypt_create_thread_ctx_key) || !thread_ctx_key_created)
+        return NULL;
+    ctx = (yescrypt_thread_ctx_t *)pthread_getspecific(thread_ctx_key);
+    if (ctx)
+        return ctx;
+
+    ctx = (yescrypt_thread_ctx_t *)malloc(sizeof(*ctx));
+    if (!ctx)
+        return NULL;
+    if (yescrypt_init_thread_ctx(ctx)) {
+        free(ctx);
+        return NULL;
     }
-    if (yescrypt_free_shared(&shared))
-        return -1;
-    
-    return retval;
+    if (pthread_setspecific(thread_ctx_key, ctx)) {
+        yescrypt_destroy_thread_ctx(ctx);
+        return NULL;
+    }
+    return ctx;
 }
 
 #else
 
-static int yescrypt_wavi(const uint8_t *passwd, size_t passwdlen,
-                            const uint8_t *salt, size_t saltlen,
-                            uint8_t *buf, size_t buflen)
+static yescrypt_thread_ctx_t *yescrypt_get_thread_ctx(void)
 {
     static __thread int initialized = 0;
-    static __thread yescrypt_shared_t shared;
-    static __thread yescrypt_local_t local;
-    int retval;
+    static __thread yescrypt_thread_ctx_t ctx;
+
     if (!initialized) {
-        /* "shared" could in fact be shared, but it's simpler to keep it private
-         * along with "local".  It's dummy and tiny anyway. */
-        if (yescrypt_init_shared(&shared, NULL, 0,
-                                 0, 0, 0, YESCRYPT_SHARED_DEFAULTS, 0, NULL, 0))
-            return -1;
-        if (yescrypt_init_local(&local)) {
-            yescrypt_free_shared(&shared);
-            return -1;
-        }
+        if (yescrypt_init_thread_ctx(&ctx))
+            return NULL;
         initialized = 1;
     }
-    retval = yescrypt_kdf(&shared, &local, passwd, passwdlen, salt, saltlen,
+    return &ctx;
+}
+
+#endif
+
+static int yescrypt_wavi(const uint8_t *passwd, size_t passwdlen,
+                            const uint8_t *salt, size_t saltlen,
+                            uint8_t *buf, size_t buflen)
+{
+    yescrypt_thread_ctx_t *ctx = yescrypt_get_thread_ctx();
+    int retval;
+
+    if (!ctx)
+        return -1;
+    retval = yescrypt_kdf(&ctx->shared, &ctx->local, passwd, passwdlen, salt, saltlen,
                           YESCRYPT_N, YESCRYPT_R, YESCRYPT_P, YESCRYPT_T,
                           YESCRYPT_FLAGS, buf, buflen);
-#if 0
-    if (yescrypt_free_local(&local)) {
-        yescrypt_free_shared(&shared);
-        return -1;
-    }
-    if (yescrypt_free_shared(&shared))
-        return -1;
-    initialized = 0;
-#endif
     if (retval < 0) {
-        yescrypt_free_local(&local);
-        yescrypt_free_shared(&shared);
+        /* drop the scratch region, the next hash of this thread allocates it again */
+        yescrypt_free_local(&ctx->local);
     }
     return retval;
 }
 
-#endif
-
 void yescrypt_hash(const char *input, char *output)
 {
     yescrypt_wavi((const uint8_t *) input, 80,
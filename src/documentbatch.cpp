@@ -0,0 +1,342 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "documentbatch.h"
+
+#include "crypto/sha256.h"
+#include "primitives/document.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#ifdef ENABLE_WALLET
+#include "net.h"
+#include "wallet/wallet.h"
+#endif
+
+static const char DB_PENDING = 'p';
+static const char DB_BATCH = 'b';
+static const char DB_LEAF = 'l'; // (leaf, root), a leaf can be in several batches
+
+std::unique_ptr<CDocumentBatcher> documentBatcher;
+
+uint256 DocumentBatchLeaf(int algo, const std::vector<unsigned char>& hash)
+{
+    const unsigned char prefix[2] = {0x00, (unsigned char)algo};
+    uint256 leaf;
+    CSHA256().Write(prefix, sizeof(prefix)).Write(hash.data(), hash.size()).Finalize(leaf.begin());
+    return leaf;
+}
+
+static uint256 DocumentBatchNode(const uint256& left, const uint256& right)
+{
+    const unsigned char prefix = 0x01;
+    uint256 node;
+    CSHA256().Write(&prefix, 1).Write(left.begin(), 32).Write(right.begin(), 32).Finalize(node.begin());
+    return node;
+}
+
+// Replace a level by its parent level, an odd last node moves up unchanged
+static void ReduceDocumentBatchLevel(std::vector<uint256>& level)
+{
+    size_t nParents = (level.size() + 1) / 2;
+    for (size_t i = 0; i < nParents; i++) {
+        if (2 * i + 1 < level.size())
+            level[i] = DocumentBatchNode(level[2 * i], level[2 * i + 1]);
+        else
+            level[i] = level[2 * i];
+    }
+    level.resize(nParents);
+}
+
+uint256 ComputeDocumentBatchRoot(std::vector<uint256> leaves)
+{
+    if (leaves.empty())
+        return uint256();
+    while (leaves.size() > 1)
+        ReduceDocumentBatchLevel(leaves);
+    return leaves[0];
+}
+
+std::vector<uint256> ComputeDocumentBatchBranch(std::vector<uint256> leaves, uint32_t nIndex)
+{
+    std::vector<uint256> branch;
+    if (nIndex >= leaves.size())
+        return branch;
+    while (leaves.size() > 1) {
+        uint32_t nSibling = nIndex ^ 1;
+        if (nSibling < leaves.size())
+            branch.push_back(leaves[nSibling]);
+        ReduceDocumentBatchLevel(leaves);
+        nIndex >>= 1;
+    }
+    return branch;
+}
+
+uint256 DocumentBatchRootFromBranch(uint256 leaf, const std::vector<uint256>& branch, uint32_t nIndex, uint32_t nCount)
+{
+    if (nIndex >= nCount)
+        return uint256();
+    size_t nUsed = 0;
+    for (uint32_t nLevelSize = nCount; nLevelSize > 1; nLevelSize = (nLevelSize + 1) / 2) {
+        uint32_t nSibling = nIndex ^ 1;
+        if (nSibling < nLevelSize) {
+            if (nUsed >= branch.size())
+                return uint256();
+            leaf = (nIndex & 1) ? DocumentBatchNode(branch[nUsed], leaf) : DocumentBatchNode(leaf, branch[nUsed]);
+            nUsed++;
+        }
+        nIndex >>= 1;
+    }
+    return nUsed == branch.size() ? leaf : uint256();
+}
+
+std::vector<unsigned char> DocumentBatchPayload(const uint256& root, uint32_t nCount)
+{
+    // "DM$", blockchain data version 0003, app id 0002 (DMS Core)
+    std::vector<unsigned char> payload = {0x44, 0x4D, 0x24, 0x00, 0x03, 0x00, 0x02};
+    payload.push_back(nCount >> 24);
+    payload.push_back(nCount >> 16);
+    payload.push_back(nCount >> 8);
+    payload.push_back(nCount);
+    payload.insert(payload.end(), root.begin(), root.end());
+    return payload;
+}
+
+CDocumentBatcher::CDocumentBatcher(size_t nCacheSize, bool fMemory, bool fWipe) :
+    db(fMemory ? "" : (GetDataDir() / "docbatch"), nCacheSize, fMemory, fWipe),
+    nLastAnchorTime(GetTime())
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(std::make_pair(DB_PENDING, (uint32_t)0));
+    while (pcursor->Valid()) {
+        std::pair<char, uint32_t> key;
+        uint256 leaf;
+        if (!pcursor->GetKey(key) || key.first != DB_PENDING || !pcursor->GetValue(leaf))
+            break;
+        if (key.second >= vPending.size())
+            vPending.resize(key.second + 1);
+        vPending[key.second] = leaf;
+        pcursor->Next();
+    }
+    if (!vPending.empty())
+        LogPrintf("%s: %u documents pending\n", __func__, vPending.size());
+}
+
+bool CDocumentBatcher::AddDocument(int algo, const std::vector<unsigned char>& hash, uint32_t& nIndexRet, std::string& strError)
+{
+    if (CDocument::HashHexLength(algo) != (int)hash.size() * 2) {
+        strError = "invalid hash length for the algorithm";
+        return false;
+    }
+
+    LOCK(cs);
+    if (vPending.size() >= MAX_DOCUMENTBATCH_SIZE) {
+        strError = "batch is full, anchor it first";
+        return false;
+    }
+
+    uint256 leaf = DocumentBatchLeaf(algo, hash);
+    nIndexRet = vPending.size();
+    if (!db.Write(std::make_pair(DB_PENDING, nIndexRet), leaf, true)) {
+        strError = "failed to write batch database";
+        return false;
+    }
+    vPending.push_back(leaf);
+    return true;
+}
+
+size_t CDocumentBatcher::GetPendingCount() const
+{
+    LOCK(cs);
+    return vPending.size();
+}
+
+bool CDocumentBatcher::GetPendingBatch(uint256& rootRet, uint32_t& nCountRet, std::vector<unsigned char>& payloadRet) const
+{
+    LOCK(cs);
+    if (vPending.empty())
+        return false;
+
+    nCountRet = vPending.size();
+    rootRet = ComputeDocumentBatchRoot(vPending);
+    payloadRet = DocumentBatchPayload(rootRet, nCountRet);
+    return true;
+}
+
+bool CDocumentBatcher::CommitPendingBatch(const uint256& root, uint32_t nCount, const uint256& txid)
+{
+    LOCK(cs);
+    // documents queued while the transaction was built stay pending
+    if (nCount == 0 || nCount > vPending.size())
+        return error("%s: only %u documents pending", __func__, vPending.size());
+
+    CDocumentBatch batch;
+    batch.vLeaves.assign(vPending.begin(), vPending.begin() + nCount);
+    if (ComputeDocumentBatchRoot(batch.vLeaves) != root)
+        return error("%s: pending documents do not match root %s", __func__, root.ToString());
+    if (db.Exists(std::make_pair(DB_BATCH, root)))
+        return error("%s: batch %s is anchored already", __func__, root.ToString());
+    batch.txid = txid;
+    batch.nTime = GetTime();
+
+    CDBBatch dbBatch(db);
+    dbBatch.Write(std::make_pair(DB_BATCH, root), batch);
+    for (size_t i = 0; i < batch.vLeaves.size(); i++)
+        dbBatch.Write(std::make_pair(DB_LEAF, std::make_pair(batch.vLeaves[i], root)), '\0');
+    for (size_t i = 0; i < vPending.size(); i++) {
+        if (i + nCount < vPending.size())
+            dbBatch.Write(std::make_pair(DB_PENDING, (uint32_t)i), vPending[i + nCount]);
+        else
+            dbBatch.Erase(std::make_pair(DB_PENDING, (uint32_t)i));
+    }
+    if (!db.WriteBatch(dbBatch, true))
+        return false;
+
+    vPending.erase(vPending.begin(), vPending.begin() + nCount);
+    nLastAnchorTime = batch.nTime;
+    return true;
+}
+
+bool CDocumentBatcher::RevertBatch(const uint256& root)
+{
+    LOCK(cs);
+    CDocumentBatch batch;
+    if (!db.Read(std::make_pair(DB_BATCH, root), batch))
+        return error("%s: batch %s missing", __func__, root.ToString());
+
+    // back to the front of the queue, ahead of documents added since
+    std::vector<uint256> vNewPending(batch.vLeaves);
+    vNewPending.insert(vNewPending.end(), vPending.begin(), vPending.end());
+
+    CDBBatch dbBatch(db);
+    dbBatch.Erase(std::make_pair(DB_BATCH, root));
+    for (size_t i = 0; i < batch.vLeaves.size(); i++)
+        dbBatch.Erase(std::make_pair(DB_LEAF, std::make_pair(batch.vLeaves[i], root)));
+    for (size_t i = 0; i < vNewPending.size(); i++)
+        dbBatch.Write(std::make_pair(DB_PENDING, (uint32_t)i), vNewPending[i]);
+    if (!db.WriteBatch(dbBatch, true))
+        return false;
+
+    vPending.swap(vNewPending);
+    return true;
+}
+
+bool CDocumentBatcher::GetProof(const uint256& leaf, CDocumentBatchProof& proof)
+{
+    LOCK(cs);
+    proof = CDocumentBatchProof();
+    proof.leaf = leaf;
+
+    uint256 root;
+    CDocumentBatch batch;
+    const std::vector<uint256>* pLeaves = &vPending;
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(std::make_pair(DB_LEAF, std::make_pair(leaf, uint256())));
+    while (pcursor->Valid()) {
+        std::pair<char, std::pair<uint256, uint256> > key;
+        if (!pcursor->GetKey(key) || key.first != DB_LEAF || key.second.first != leaf)
+            break;
+        CDocumentBatch candidate;
+        if (!db.Read(std::make_pair(DB_BATCH, key.second.second), candidate))
+            return error("%s: batch %s missing", __func__, key.second.second.ToString());
+        if (pLeaves == &vPending || candidate.nTime < batch.nTime) {
+            root = key.second.second;
+            batch.vLeaves.swap(candidate.vLeaves);
+            batch.txid = candidate.txid;
+            batch.nTime = candidate.nTime;
+            pLeaves = &batch.vLeaves;
+            proof.txid = batch.txid;
+        }
+        pcursor->Next();
+    }
+
+    std::vector<uint256>::const_iterator it = std::find(pLeaves->begin(), pLeaves->end(), leaf);
+    if (it == pLeaves->end())
+        return false;
+
+    proof.nIndex = it - pLeaves->begin();
+    proof.nCount = pLeaves->size();
+    proof.vBranch = ComputeDocumentBatchBranch(*pLeaves, proof.nIndex);
+    proof.root = proof.txid.IsNull() ? ComputeDocumentBatchRoot(*pLeaves) : root;
+    return true;
+}
+
+void CDocumentBatcher::DoMaintenance()
+{
+    int64_t nInterval = GetArg("-documentbatchinterval", DEFAULT_DOCUMENTBATCH_INTERVAL);
+    if (nInterval <= 0 || fImporting || fReindex || IsInitialBlockDownload())
+        return;
+
+    {
+        LOCK(cs);
+        if (vPending.empty() || GetTime() - nLastAnchorTime < nInterval)
+            return;
+    }
+
+    uint256 txid, root;
+    uint32_t nCount;
+    std::string strError;
+    if (AnchorDocumentBatch(txid, root, nCount, strError))
+        LogPrintf("%s: anchored %u documents, root %s, tx %s\n", __func__, nCount, root.ToString(), txid.ToString());
+    else
+        LogPrintf("%s: anchoring failed: %s\n", __func__, strError);
+}
+
+bool AnchorDocumentBatch(uint256& txidRet, uint256& rootRet, uint32_t& nCountRet, std::string& strError)
+{
+    if (!documentBatcher) {
+        strError = "document batching not enabled (-documentbatch)";
+        return false;
+    }
+
+#ifdef ENABLE_WALLET
+    if (!pwalletMain) {
+        strError = "wallet disabled";
+        return false;
+    }
+
+    LOCK2(cs_main, pwalletMain->cs_wallet);
+    if (pwalletMain->IsLocked()) {
+        strError = "wallet locked";
+        return false;
+    }
+
+    std::vector<unsigned char> payload;
+    if (!documentBatcher->GetPendingBatch(rootRet, nCountRet, payload)) {
+        strError = "no pending documents";
+        return false;
+    }
+
+    std::vector<CRecipient> vecSend;
+    vecSend.push_back(CRecipient{CScript() << OP_RETURN << payload, 0, false});
+
+    CWalletTx wtx;
+    CReserveKey reservekey(pwalletMain);
+    CAmount nFeeRequired;
+    int nChangePos = -1;
+    if (!pwalletMain->CreateTransaction(vecSend, wtx, reservekey, nFeeRequired, nChangePos, strError))
+        return false;
+
+    // the batch is stored before the transaction is sent and reverted if that fails,
+    // so documents are neither anchored twice nor left without a stored batch
+    txidRet = wtx.GetHash();
+    if (!documentBatcher->CommitPendingBatch(rootRet, nCountRet, txidRet)) {
+        strError = "failed to store batch";
+        return false;
+    }
+
+    CValidationState state;
+    if (!pwalletMain->CommitTransaction(wtx, reservekey, g_connman.get(), state)) {
+        if (!documentBatcher->RevertBatch(rootRet))
+            LogPrintf("%s: failed to revert batch %s\n", __func__, rootRet.ToString());
+        strError = "transaction rejected: " + state.GetRejectReason();
+        return false;
+    }
+    return true;
+#else
+    strError = "wallet support not compiled in";
+    return false;
+#endif
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_DOCUMENTBATCH_H
+#define DMS_DOCUMENTBATCH_H
+
+#include "dbwrapper.h"
+#include "serialize.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/** -documentbatch default (collect documents and anchor them in batches) */
+static const bool DEFAULT_DOCUMENTBATCH = false;
+/** -documentbatchinterval default (seconds between automatic anchors, 0 = only by RPC) */
+static const int64_t DEFAULT_DOCUMENTBATCH_INTERVAL = 0;
+/** Maximum number of documents in one batch */
+static const uint32_t MAX_DOCUMENTBATCH_SIZE = 1 << 20;
+
+// A batch commits to many file hashes with a single DM$ output of blockchain data version 0003:
+//   "DM$" 0x0003 <app id, 2 bytes> <leaf count, 4 bytes big endian> <SHA-256 Merkle root, 32 bytes>
+// Leaves are SHA-256(0x00 || algo || file hash), inner nodes SHA-256(0x01 || left || right).
+// An odd node at the end of a level is promoted unchanged, so no two trees share a root.
+uint256 DocumentBatchLeaf(int algo, const std::vector<unsigned char>& hash);
+uint256 ComputeDocumentBatchRoot(std::vector<uint256> leaves);
+std::vector<uint256> ComputeDocumentBatchBranch(std::vector<uint256> leaves, uint32_t nIndex);
+uint256 DocumentBatchRootFromBranch(uint256 leaf, const std::vector<uint256>& branch, uint32_t nIndex, uint32_t nCount);
+std::vector<unsigned char> DocumentBatchPayload(const uint256& root, uint32_t nCount);
+
+struct CDocumentBatch
+{
+    std::vector<uint256> vLeaves;
+    uint256 txid;
+    int64_t nTime;
+
+    CDocumentBatch() : nTime(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vLeaves);
+        READWRITE(txid);
+        READWRITE(nTime);
+    }
+};
+
+struct CDocumentBatchProof
+{
+    uint256 leaf;
+    uint256 root;
+    uint32_t nIndex;
+    uint32_t nCount;
+    std::vector<uint256> vBranch;
+    uint256 txid;   // null while the batch is pending
+
+    CDocumentBatchProof() : nIndex(0), nCount(0) {}
+};
+
+// Collects file hashes and anchors them as one batch. Pending leaves and every anchored batch are
+// kept in their own database (datadir/docbatch), so proofs can be served for the lifetime of the node.
+class CDocumentBatcher
+{
+private:
+    mutable CCriticalSection cs;
+    CDBWrapper db;
+    std::vector<uint256> vPending;
+    int64_t nLastAnchorTime;
+
+public:
+    CDocumentBatcher(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    /** Queue a file hash for the next batch, returns its position in the batch */
+    bool AddDocument(int algo, const std::vector<unsigned char>& hash, uint32_t& nIndexRet, std::string& strError);
+    size_t GetPendingCount() const;
+
+    /** Root and payload of the pending documents, false if there are none */
+    bool GetPendingBatch(uint256& rootRet, uint32_t& nCountRet, std::vector<unsigned char>& payloadRet) const;
+    /** Store the first nCount pending documents as batch anchored by txid */
+    bool CommitPendingBatch(const uint256& root, uint32_t nCount, const uint256& txid);
+    /** Undo CommitPendingBatch when its transaction could not be sent, the documents become pending again */
+    bool RevertBatch(const uint256& root);
+
+    /** Proof from the earliest batch holding the leaf, or from the pending documents */
+    bool GetProof(const uint256& leaf, CDocumentBatchProof& proof);
+
+    void DoMaintenance();
+};
+
+extern std::unique_ptr<CDocumentBatcher> documentBatcher;
+
+/** Send the pending documents with the wallet, returns the anchoring transaction */
+bool AnchorDocumentBatch(uint256& txidRet, uint256& rootRet, uint32_t& nCountRet, std::string& strError);
+
+#endif // DMS_DOCUMENTBATCH_H
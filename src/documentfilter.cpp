@@ -0,0 +1,229 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "documentfilter.h"
+
+#include "crypto/common.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "primitives/document.h"
+#include "streams.h"
+#include "version.h"
+
+#include <algorithm>
+#include <set>
+
+namespace {
+
+/** Appends bits to a byte vector, the most significant bit of each byte first */
+class CBitWriter
+{
+private:
+    std::vector<unsigned char>& vch;
+    uint8_t nBuffer;
+    int nOffset;
+
+public:
+    explicit CBitWriter(std::vector<unsigned char>& vchIn) : vch(vchIn), nBuffer(0), nOffset(0) {}
+
+    /** Write the nBits (at most 64) low bits of data */
+    void Write(uint64_t data, int nBits)
+    {
+        while (nBits > 0) {
+            int nChunk = std::min(8 - nOffset, nBits);
+            nBuffer |= (data << (64 - nBits)) >> (64 - 8 + nOffset);
+            nOffset += nChunk;
+            nBits -= nChunk;
+            if (nOffset == 8)
+                Flush();
+        }
+    }
+
+    void Flush()
+    {
+        if (nOffset == 0)
+            return;
+        vch.push_back(nBuffer);
+        nBuffer = 0;
+        nOffset = 0;
+    }
+};
+
+class CBitReader
+{
+private:
+    const unsigned char* pnext;
+    const unsigned char* pend;
+    uint8_t nBuffer;
+    int nOffset;
+
+public:
+    CBitReader(const unsigned char* pbegin, const unsigned char* pendIn) : pnext(pbegin), pend(pendIn), nBuffer(0), nOffset(8) {}
+
+    uint64_t Read(int nBits)
+    {
+        uint64_t data = 0;
+        while (nBits > 0) {
+            if (nOffset == 8) {
+                if (pnext == pend)
+                    throw std::ios_base::failure("document filter truncated");
+                nBuffer = *pnext++;
+                nOffset = 0;
+            }
+            int nChunk = std::min(8 - nOffset, nBits);
+            data <<= nChunk;
+            data |= static_cast<uint8_t>(nBuffer << nOffset) >> (8 - nChunk);
+            nOffset += nChunk;
+            nBits -= nChunk;
+        }
+        return data;
+    }
+};
+
+void GolombRiceEncode(CBitWriter& writer, uint64_t x)
+{
+    // quotient in unary, ones terminated by a zero
+    for (uint64_t q = x >> DOCUMENT_FILTER_P; q > 0; ) {
+        int nBits = (int)std::min<uint64_t>(q, 64);
+        writer.Write(~0ULL, nBits);
+        q -= nBits;
+    }
+    writer.Write(0, 1);
+    writer.Write(x, DOCUMENT_FILTER_P);
+}
+
+uint64_t GolombRiceDecode(CBitReader& reader)
+{
+    uint64_t q = 0;
+    while (reader.Read(1) == 1)
+        q++;
+    return (q << DOCUMENT_FILTER_P) + reader.Read(DOCUMENT_FILTER_P);
+}
+
+/** floor(x * n / 2^64), maps a uniform 64 bit hash into [0, n) without a division */
+uint64_t MapIntoRange(uint64_t x, uint64_t n)
+{
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)(((unsigned __int128)x * n) >> 64);
+#else
+    uint64_t xHi = x >> 32, xLo = x & 0xffffffff;
+    uint64_t nHi = n >> 32, nLo = n & 0xffffffff;
+    uint64_t mid = xHi * nLo + ((xLo * nLo) >> 32);
+    uint64_t mid2 = xLo * nHi + (mid & 0xffffffff);
+    return xHi * nHi + (mid >> 32) + (mid2 >> 32);
+#endif
+}
+
+} // namespace
+
+uint64_t CDocumentFilter::HashToRange(const Element& element) const
+{
+    uint64_t hash = CSipHasher(ReadLE64(blockHash.begin()), ReadLE64(blockHash.begin() + 8))
+        .Write(element.data(), element.size())
+        .Finalize();
+    return MapIntoRange(hash, nElements * DOCUMENT_FILTER_M);
+}
+
+CDocumentFilter::CDocumentFilter(const uint256& blockHashIn, const std::vector<Element>& vElements) :
+    blockHash(blockHashIn)
+{
+    std::set<Element> setElements(vElements.begin(), vElements.end());
+    nElements = setElements.size();
+
+    std::vector<uint64_t> vHashes;
+    vHashes.reserve(nElements);
+    for (const Element& element : setElements)
+        vHashes.push_back(HashToRange(element));
+    std::sort(vHashes.begin(), vHashes.end());
+
+    CVectorWriter stream(SER_NETWORK, PROTOCOL_VERSION, vEncoded, 0);
+    WriteCompactSize(stream, nElements);
+    CBitWriter writer(vEncoded);
+    uint64_t nLast = 0;
+    for (uint64_t hash : vHashes) {
+        GolombRiceEncode(writer, hash - nLast);
+        nLast = hash;
+    }
+    writer.Flush();
+}
+
+CDocumentFilter::CDocumentFilter(const uint256& blockHashIn, std::vector<unsigned char> vEncodedIn) :
+    blockHash(blockHashIn), vEncoded(std::move(vEncodedIn))
+{
+    const char* pbegin = (const char*)vEncoded.data();
+    CDataStream stream(pbegin, pbegin + std::min<size_t>(vEncoded.size(), 9), SER_NETWORK, PROTOCOL_VERSION);
+    nElements = ReadCompactSize(stream);
+
+    // every element has to be decodable, so that Match never runs past the data
+    CBitReader reader(vEncoded.data() + GetSizeOfCompactSize(nElements), vEncoded.data() + vEncoded.size());
+    for (uint64_t i = 0; i < nElements; i++)
+        GolombRiceDecode(reader);
+}
+
+bool CDocumentFilter::MatchInternal(const uint64_t* pbegin, const uint64_t* pend) const
+{
+    // merge the sorted queries with the sorted set
+    const unsigned char* pdata = vEncoded.data() + GetSizeOfCompactSize(nElements);
+    CBitReader reader(pdata, vEncoded.data() + vEncoded.size());
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < nElements && pbegin != pend; i++) {
+        value += GolombRiceDecode(reader);
+        while (pbegin != pend && *pbegin < value)
+            pbegin++;
+        if (pbegin != pend && *pbegin == value)
+            return true;
+    }
+    return false;
+}
+
+bool CDocumentFilter::Match(const Element& element) const
+{
+    if (nElements == 0)
+        return false;
+    uint64_t hash = HashToRange(element);
+    return MatchInternal(&hash, &hash + 1);
+}
+
+bool CDocumentFilter::MatchAny(const std::vector<Element>& vElements) const
+{
+    if (nElements == 0 || vElements.empty())
+        return false;
+    std::vector<uint64_t> vHashes;
+    vHashes.reserve(vElements.size());
+    for (const Element& element : vElements)
+        vHashes.push_back(HashToRange(element));
+    std::sort(vHashes.begin(), vHashes.end());
+    return MatchInternal(vHashes.data(), vHashes.data() + vHashes.size());
+}
+
+uint256 CDocumentFilter::GetHash() const
+{
+    return Hash(vEncoded.begin(), vEncoded.end());
+}
+
+uint256 CDocumentFilter::ComputeHeader(const uint256& prevHeader) const
+{
+    uint256 hash = GetHash();
+    return Hash(hash.begin(), hash.end(), prevHeader.begin(), prevHeader.end());
+}
+
+std::vector<CDocumentFilter::Element> GetDocumentFilterElements(const CBlock& block)
+{
+    std::set<CDocumentFilter::Element> setElements;
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->IsCoinBase())
+            continue;
+        for (const CTxOut& txout : tx->vout) {
+            CDocumentRef document;
+            if (!txout.GetDocumentRef(document))
+                continue;
+            for (const CDocumentHashRef* pHash : {&document.guid, &document.indexhash, &document.filehash,
+                                                  &document.attrhash, &document.ownerhash, &document.merkleroot}) {
+                if (!pHash->IsNull())
+                    setElements.insert(CDocumentFilter::Element(pHash->begin(), pHash->end()));
+            }
+        }
+    }
+    return std::vector<CDocumentFilter::Element>(setElements.begin(), setElements.end());
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_DOCUMENTFILTER_H
+#define DMS_DOCUMENTFILTER_H
+
+#include "uint256.h"
+
+#include <stdint.h>
+#include <vector>
+
+class CBlock;
+
+/** Golomb-Rice parameter and false positive rate 1/M, those of the BIP 158 basic filter */
+static const uint8_t DOCUMENT_FILTER_P = 19;
+static const uint32_t DOCUMENT_FILTER_M = 784931;
+/** Maximum number of filters or filter hashes answered to one request */
+static const unsigned int MAX_GETDOCFILTERS_SIZE = 1000;
+static const unsigned int MAX_GETDOCFHEADERS_SIZE = 2000;
+
+// A document filter is a Golomb-coded set (BIP 158) over the raw bytes of all hashes in the
+// DM$ outputs of a block: GUID, index and file hash, attribute and owner hash, batch root.
+// Elements are mapped by SipHash keyed with the first 16 bytes of the block hash into
+// [0, N * M), sorted, and the differences stored Golomb-Rice coded after N as CompactSize.
+// A client that knows its own file hashes downloads the filters, usually a single byte for
+// blocks without documents, and fetches only the blocks that match. As with BIP 157, the
+// header of a filter is Hash(Hash(filter) || header of the previous block's filter), so the
+// filters of a whole chain can be checked against a single header from a trusted source.
+class CDocumentFilter
+{
+public:
+    typedef std::vector<unsigned char> Element;
+
+private:
+    uint256 blockHash;
+    std::vector<unsigned char> vEncoded;
+    uint64_t nElements;
+
+    uint64_t HashToRange(const Element& element) const;
+    bool MatchInternal(const uint64_t* pbegin, const uint64_t* pend) const;
+
+public:
+    CDocumentFilter() : nElements(0) {}
+    CDocumentFilter(const uint256& blockHashIn, const std::vector<Element>& vElements);
+    /** Load an encoded filter, throws std::ios_base::failure if it is malformed */
+    CDocumentFilter(const uint256& blockHashIn, std::vector<unsigned char> vEncodedIn);
+
+    const uint256& GetBlockHash() const { return blockHash; }
+    const std::vector<unsigned char>& GetEncoded() const { return vEncoded; }
+    uint64_t GetN() const { return nElements; }
+
+    /** Whether the element is in the set, or one of the false positives */
+    bool Match(const Element& element) const;
+    bool MatchAny(const std::vector<Element>& vElements) const;
+
+    uint256 GetHash() const;
+    uint256 ComputeHeader(const uint256& prevHeader) const;
+};
+
+/** The distinct document hashes of all DM$ outputs in the block */
+std::vector<CDocumentFilter::Element> GetDocumentFilterElements(const CBlock& block);
+
+#endif // DMS_DOCUMENTFILTER_H
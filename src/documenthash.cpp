@@ -0,0 +1,157 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "documenthash.h"
+
+#include "crypto/sha3.h"
+#include "util.h"
+
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <thread>
+
+#include <openssl/evp.h>
+
+namespace {
+
+// MD5, SHA-1 and SHA-2 come from OpenSSL, SHA-3 from our own Keccak as the bundled OpenSSL predates it
+const EVP_MD* GetOpenSSLDigest(int algo)
+{
+    switch (algo) {
+        case  0: return EVP_md5();
+        case  1: return EVP_sha1();
+        case 21: return EVP_sha224();
+        case 22: return EVP_sha256();
+        case 23: return EVP_sha384();
+        case 25: return EVP_sha512();
+        default: return nullptr;
+    }
+}
+
+size_t GetSHA3OutputSize(int algo)
+{
+    switch (algo) {
+        case 31: return 28;
+        case 32: return 32;
+        case 33: return 48;
+        case 35: return 64;
+        default: return 0;
+    }
+}
+
+class CDocumentHasher
+{
+private:
+    EVP_MD_CTX* ctx;
+    std::unique_ptr<CSHA3> sha3;
+
+public:
+    explicit CDocumentHasher(int algo) : ctx(nullptr)
+    {
+        if (const EVP_MD* md = GetOpenSSLDigest(algo)) {
+            ctx = EVP_MD_CTX_create();
+            EVP_DigestInit_ex(ctx, md, nullptr);
+        } else {
+            sha3.reset(new CSHA3(GetSHA3OutputSize(algo)));
+        }
+    }
+
+    ~CDocumentHasher()
+    {
+        if (ctx)
+            EVP_MD_CTX_destroy(ctx);
+    }
+
+    void Write(const unsigned char* data, size_t len)
+    {
+        if (ctx)
+            EVP_DigestUpdate(ctx, data, len);
+        else
+            sha3->Write(data, len);
+    }
+
+    std::vector<unsigned char> Finalize()
+    {
+        std::vector<unsigned char> hash;
+        if (ctx) {
+            unsigned int nLen = 0;
+            hash.resize(EVP_MAX_MD_SIZE);
+            EVP_DigestFinal_ex(ctx, hash.data(), &nLen);
+            hash.resize(nLen);
+        } else {
+            hash.resize(sha3->OutputSize());
+            sha3->Finalize(hash.data());
+        }
+        return hash;
+    }
+};
+
+} // namespace
+
+bool IsDocumentHashAlgoSupported(int algo)
+{
+    return GetOpenSSLDigest(algo) || GetSHA3OutputSize(algo);
+}
+
+bool HashDocumentFile(CDocumentFileHashes& file, const std::vector<int>& vAlgos)
+{
+    file.nSize = 0;
+    file.vHashes.clear();
+    file.strError.clear();
+
+    std::vector<std::unique_ptr<CDocumentHasher> > vHashers;
+    for (int algo : vAlgos) {
+        if (!IsDocumentHashAlgoSupported(algo)) {
+            file.strError = strprintf("unsupported hash algorithm %d", algo);
+            return false;
+        }
+        vHashers.emplace_back(new CDocumentHasher(algo));
+    }
+
+    FILE* pfile = fopen(file.strPath.c_str(), "rb");
+    if (!pfile) {
+        file.strError = "cannot open file";
+        return false;
+    }
+
+    std::vector<unsigned char> vBuffer(DOCUMENT_HASH_READ_SIZE);
+    size_t nRead;
+    while ((nRead = fread(vBuffer.data(), 1, vBuffer.size(), pfile)) > 0) {
+        for (const auto& hasher : vHashers)
+            hasher->Write(vBuffer.data(), nRead);
+        file.nSize += nRead;
+    }
+    bool fError = ferror(pfile);
+    fclose(pfile);
+    if (fError) {
+        file.strError = "read error";
+        return false;
+    }
+
+    for (const auto& hasher : vHashers)
+        file.vHashes.push_back(hasher->Finalize());
+    return true;
+}
+
+void HashDocumentFiles(std::vector<CDocumentFileHashes>& vFiles, const std::vector<int>& vAlgos, int nThreads)
+{
+    if (nThreads <= 0)
+        nThreads = GetNumCores();
+    nThreads = std::max(1, std::min(nThreads, (int)vFiles.size()));
+
+    // reading one file while others are hashed keeps both the disk and the cores busy
+    std::atomic<size_t> nNext(0);
+    auto worker = [&vFiles, &vAlgos, &nNext]() {
+        for (size_t i = nNext++; i < vFiles.size(); i = nNext++)
+            HashDocumentFile(vFiles[i], vAlgos);
+    };
+
+    std::vector<std::thread> vWorkers;
+    for (int i = 1; i < nThreads; i++)
+        vWorkers.emplace_back(worker);
+    worker();
+    for (std::thread& t : vWorkers)
+        t.join();
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_DOCUMENTHASH_H
+#define DMS_DOCUMENTHASH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Bytes read from a file at once, each is fed to all hash algorithms before the next read */
+static const size_t DOCUMENT_HASH_READ_SIZE = 1 << 20;
+
+/** The file hashes of one document, in the order of the requested algorithms */
+struct CDocumentFileHashes
+{
+    std::string strPath;
+    uint64_t nSize;
+    std::vector<std::vector<unsigned char> > vHashes;
+    std::string strError;  // empty if the file was hashed
+
+    CDocumentFileHashes() : nSize(0) {}
+    explicit CDocumentFileHashes(const std::string& strPathIn) : strPath(strPathIn), nSize(0) {}
+};
+
+/** Whether the document algorithm id (see CDocumentHash::AlgoName) can hash files */
+bool IsDocumentHashAlgoSupported(int algo);
+
+/** Read the file once and compute the hashes of all algorithms in that single pass */
+bool HashDocumentFile(CDocumentFileHashes& file, const std::vector<int>& vAlgos);
+
+/** Hash many files, each of nThreads workers (0 = one per core) takes the next file not yet hashed */
+void HashDocumentFiles(std::vector<CDocumentFileHashes>& vFiles, const std::vector<int>& vAlgos, int nThreads = 0);
+
+#endif // DMS_DOCUMENTHASH_H
@@ -0,0 +1,206 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "documentindexer.h"
+
+#include "chainparams.h"
+#include "txdb.h"
+#include "txmempool.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <atomic>
+
+#include <boost/thread.hpp>
+
+/** How often the progress of blocks without documents is saved */
+static const int64_t DOCUMENTINDEXER_LOCATOR_INTERVAL = 30 * 1000;
+
+static std::atomic<bool> fIndexerBuilding{false};
+static std::atomic<bool> fIndexerDropping{false};
+static std::atomic<int> nIndexerBestHeight{-1};
+
+static void GetBlockDocumentIndexEntries(const CBlock& block, int nHeight,
+                                         std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >& documentIndex,
+                                         std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& documentHashIndex)
+{
+    for (size_t i = 0; i < block.vtx.size(); i++)
+        GetDocumentIndexEntries(*block.vtx[i], nHeight, i, documentIndex, documentHashIndex);
+}
+
+// Remove the entries of blocks that left the active chain, from pindexBest back to pindexFork
+static bool RewindDocumentIndex(const CBlockIndex* pindexBest, const CBlockIndex* pindexFork, const Consensus::Params& params)
+{
+    AssertLockHeld(cs_main);
+
+    for (const CBlockIndex* pindex = pindexBest; pindex != pindexFork; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, params))
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+
+        std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > documentIndex;
+        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentHashIndex;
+        GetBlockDocumentIndexEntries(block, pindex->nHeight, documentIndex, documentHashIndex);
+
+        CBlockLocator locator = chainActive.GetLocator(pindex->pprev);
+        if (!pblocktree->EraseDocumentIndex(documentIndex, documentHashIndex, pindex->nHeight, &locator))
+            return error("%s: failed to erase document index of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    return true;
+}
+
+static void DropDocumentIndex()
+{
+    fIndexerDropping = true;
+    LogPrintf("%s: dropping the document index\n", __func__);
+    if (pblocktree->EraseDocumentIndexData())
+        LogPrintf("%s: document index dropped\n", __func__);
+    else
+        LogPrintf("%s: failed to drop the document index\n", __func__);
+    fIndexerDropping = false;
+}
+
+static void SyncDocumentIndex(const Consensus::Params& params)
+{
+    const CBlockIndex* pindexBest = nullptr;
+    CBlockLocator locator;
+    if (pblocktree->HasLegacyDocumentIndex()) {
+        // written with the old key format, possibly only in part, start over
+        LogPrintf("%s: upgrading the document index\n", __func__);
+        DropDocumentIndex();
+    }
+    if (pblocktree->ReadDocumentIndexBest(locator) && !locator.IsNull()) {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(locator.vHave.front());
+        if (mi == mapBlockIndex.end()) {
+            LogPrintf("%s: unknown best block %s, rebuilding the document index\n", __func__, locator.vHave.front().ToString());
+            pblocktree->EraseDocumentIndexData();
+        } else {
+            pindexBest = mi->second;
+        }
+    } else if (pblocktree->HasDocumentIndexData()) {
+        // left over from an interrupted drop
+        DropDocumentIndex();
+    }
+
+    fIndexerBuilding = true;
+    nIndexerBestHeight = pindexBest ? pindexBest->nHeight : -1;
+    LogPrintf("%s: building the document index from height %d\n", __func__, nIndexerBestHeight + 1);
+
+    int64_t nLastLocatorWrite = GetTimeMillis();
+    while (true) {
+        boost::this_thread::interruption_point();
+
+        const CBlockIndex* pindexNext;
+        {
+            LOCK(cs_main);
+            if (pindexBest && !chainActive.Contains(pindexBest)) {
+                const CBlockIndex* pindexFork = chainActive.FindFork(pindexBest);
+                if (!RewindDocumentIndex(pindexBest, pindexFork, params)) {
+                    fIndexerBuilding = false;
+                    return;
+                }
+                pindexBest = pindexFork;
+            }
+
+            pindexNext = pindexBest ? chainActive.Next(pindexBest) : chainActive.Genesis();
+            if (!pindexNext) {
+                // caught up with the tip, ConnectBlock maintains the index from the next block on
+                // and AcceptToMemoryPool from the next transaction, the pool is indexed under the same lock
+                pblocktree->WriteFlag("documentindex", true);
+                pblocktree->EraseDocumentIndexBest();
+                mempool.addDocumentIndexes();
+                fDocumentIndex = true;
+                fIndexerBuilding = false;
+                LogPrintf("%s: document index synced at height %d\n", __func__, nIndexerBestHeight);
+                return;
+            }
+
+            if (!(pindexNext->nStatus & BLOCK_HAVE_DATA)) {
+                LogPrintf("%s: block %d is pruned, the document index cannot be built\n", __func__, pindexNext->nHeight);
+                fIndexerBuilding = false;
+                return;
+            }
+        }
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindexNext, params)) {
+            LogPrintf("%s: failed to read block %s\n", __func__, pindexNext->GetBlockHash().ToString());
+            fIndexerBuilding = false;
+            return;
+        }
+
+        std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > documentIndex;
+        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentHashIndex;
+        GetBlockDocumentIndexEntries(block, pindexNext->nHeight, documentIndex, documentHashIndex);
+
+        {
+            LOCK(cs_main);
+            // reorganized while reading the block, try again
+            if (!chainActive.Contains(pindexNext))
+                continue;
+
+            // entries and locator are written in one batch, so the index never holds
+            // documents of blocks beyond its locator
+            int64_t nNow = GetTimeMillis();
+            if (!documentIndex.empty() || !documentHashIndex.empty()) {
+                CBlockLocator locatorNext = chainActive.GetLocator(pindexNext);
+                if (!pblocktree->WriteDocumentIndex(documentIndex, documentHashIndex, pindexNext->nHeight, &locatorNext)) {
+                    LogPrintf("%s: failed to write document index\n", __func__);
+                    fIndexerBuilding = false;
+                    return;
+                }
+                nLastLocatorWrite = nNow;
+            } else if (nNow - nLastLocatorWrite > DOCUMENTINDEXER_LOCATOR_INTERVAL) {
+                pblocktree->WriteDocumentIndexBest(chainActive.GetLocator(pindexNext));
+                nLastLocatorWrite = nNow;
+            }
+
+            pindexBest = pindexNext;
+            nIndexerBestHeight = pindexBest->nHeight;
+        }
+    }
+}
+
+static void ThreadDocumentIndexer()
+{
+    if (GetBoolArg("-documentindex", DEFAULT_DOCUMENTINDEX))
+        SyncDocumentIndex(Params().GetConsensus());
+    else
+        DropDocumentIndex();
+}
+
+void StartDocumentIndexer(boost::thread_group& threadGroup)
+{
+    bool fWanted = GetBoolArg("-documentindex", DEFAULT_DOCUMENTINDEX);
+    if (fDocumentIndex && fWanted)
+        return;
+    if (!fDocumentIndex && !fWanted && !pblocktree->HasDocumentIndexData())
+        return;
+
+    if (fDocumentIndex) {
+        // stop using the index right away, the data is deleted in the background
+        LOCK(cs_main);
+        pblocktree->WriteFlag("documentindex", false);
+        fDocumentIndex = false;
+    }
+
+    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "docindex", &ThreadDocumentIndexer));
+}
+
+CDocumentIndexerStatus GetDocumentIndexerStatus()
+{
+    CDocumentIndexerStatus status;
+    status.fSynced = fDocumentIndex;
+    status.fBuilding = fIndexerBuilding;
+    status.fDropping = fIndexerDropping;
+    if (status.fSynced) {
+        LOCK(cs_main);
+        status.nBestHeight = chainActive.Height();
+    } else {
+        status.nBestHeight = status.fBuilding ? nIndexerBestHeight.load() : -1;
+    }
+    return status;
+}
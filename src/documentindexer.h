@@ -0,0 +1,32 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_DOCUMENTINDEXER_H
+#define DMS_DOCUMENTINDEXER_H
+
+namespace boost {
+class thread_group;
+} // namespace boost
+
+// Enabling -documentindex on an existing node does not need a -reindex: a background thread walks
+// the active chain from the block files and fills the document index while the node keeps running.
+// Its progress is stored as a block locator, so it resumes after a restart and rewinds itself after
+// a reorg. Once it reaches the tip, the "documentindex" flag is set and ConnectBlock/DisconnectBlock
+// maintain the index from the next block on. Disabling -documentindex drops the index in the same
+// thread without touching the rest of the block tree database. An index written with an older
+// CDocumentIndexKey version is dropped and rebuilt the same way.
+struct CDocumentIndexerStatus
+{
+    bool fSynced;      // index complete, maintained by ConnectBlock
+    bool fBuilding;    // background thread is filling the index
+    bool fDropping;    // background thread is deleting the index
+    int nBestHeight;   // height of the last indexed block, -1 if none
+};
+
+/** Start the background thread if the index has to be built or dropped (call after the chain is loaded) */
+void StartDocumentIndexer(boost::thread_group& threadGroup);
+
+CDocumentIndexerStatus GetDocumentIndexerStatus();
+
+#endif // DMS_DOCUMENTINDEXER_H
@@ -270,6 +270,8 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
         // SEND NOTIFICATION TO SCRIPT/ZMQ
+        // votes are processed by several message handler threads, cs_main keeps the notifications serial
+        LOCK(cs_main);
         GetMainSignals().NotifyGovernanceVote(vote);
     }
 }
@@ -0,0 +1,93 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "headerhash.h"
+
+#include "util.h"
+
+#include <future>
+#include <list>
+
+static std::unique_ptr<CHeaderHashWorker> headerHashWorker;
+
+CHeaderHashWorker::CHeaderHashWorker(int nThreads)
+{
+    workerPool.resize(nThreads);
+
+    RenameThreadPool(workerPool, "hdrhash");
+}
+
+CHeaderHashWorker::~CHeaderHashWorker()
+{
+    Stop();
+}
+
+void CHeaderHashWorker::Stop()
+{
+    workerPool.clear_queue();
+    workerPool.stop(true);
+}
+
+std::vector<uint256> CHeaderHashWorker::HashHeaders(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<uint256> hashes(headers.size());
+    if (headers.empty()) {
+        return hashes;
+    }
+
+    // the calling thread takes the last batch, so split the work over the pool plus one
+    size_t nThreads = workerPool.size() + 1;
+    size_t batchSize = std::max(MIN_BATCH_SIZE, (headers.size() + nThreads - 1) / nThreads);
+
+    std::list<std::future<void> > futures;
+    for (size_t i = 0; i < headers.size(); i += batchSize) {
+        size_t start = i;
+        size_t count = std::min(batchSize, headers.size() - start);
+        if (start + count == headers.size()) {
+            // hash the last batch on the calling thread instead of waiting idle
+            for (size_t j = start; j < start + count; j++) {
+                hashes[j] = headers[j].GetHash();
+            }
+            break;
+        }
+        auto f = [&headers, &hashes, start, count](int threadId) {
+            for (size_t j = start; j < start + count; j++) {
+                hashes[j] = headers[j].GetHash();
+            }
+        };
+        futures.emplace_back(workerPool.push(f));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    return hashes;
+}
+
+void StartHeaderHashWorker(int nThreads)
+{
+    assert(!headerHashWorker);
+    if (nThreads <= 1) {
+        return;
+    }
+    // the calling thread hashes one batch itself
+    headerHashWorker.reset(new CHeaderHashWorker(nThreads - 1));
+}
+
+void StopHeaderHashWorker()
+{
+    headerHashWorker.reset();
+}
+
+std::vector<uint256> HashBlockHeaders(const std::vector<CBlockHeader>& headers)
+{
+    if (headerHashWorker && headers.size() > 1) {
+        return headerHashWorker->HashHeaders(headers);
+    }
+    std::vector<uint256> hashes;
+    hashes.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        hashes.emplace_back(header.GetHash());
+    }
+    return hashes;
+}
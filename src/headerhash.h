@@ -0,0 +1,48 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_HEADERHASH_H
+#define DMS_HEADERHASH_H
+
+#include "ctpl.h"
+#include "primitives/block.h"
+#include "uint256.h"
+
+#include <memory>
+#include <vector>
+
+/** Maximum number of header hashing threads */
+static const int MAX_HEADERHASH_THREADS = 16;
+/** -parheaders default (number of header hashing threads, 0 = auto) */
+static const int DEFAULT_HEADERHASH_THREADS = 0;
+
+// Every block header hash is a full yescrypt run. A headers message carries up to 2000 headers,
+// which are independent of each other and are hashed in parallel by this worker. Each pool thread
+// keeps its own yescrypt context (see yescrypt_wavi), so the workers do not share any state.
+class CHeaderHashWorker
+{
+private:
+    ctpl::thread_pool workerPool;
+
+    // headers per job, small enough to spread a single headers message over all threads
+    static const size_t MIN_BATCH_SIZE = 16;
+
+public:
+    explicit CHeaderHashWorker(int nThreads);
+    ~CHeaderHashWorker();
+
+    void Stop();
+
+    // Returns the hashes in the same order as the headers. Blocks until all hashes are computed.
+    std::vector<uint256> HashHeaders(const std::vector<CBlockHeader>& headers);
+};
+
+/** Start the global header hashing pool, nThreads <= 1 leaves hashing on the calling thread */
+void StartHeaderHashWorker(int nThreads);
+void StopHeaderHashWorker();
+
+/** Hash all headers, using the header hashing pool if it is running */
+std::vector<uint256> HashBlockHeaders(const std::vector<CBlockHeader>& headers);
+
+#endif // DMS_HEADERHASH_H
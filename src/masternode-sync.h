@@ -40,8 +40,8 @@ private:
 
     // Time when current masternode asset sync started
     int64_t nTimeAssetSyncStarted;
-    // ... last bumped
-    int64_t nTimeLastBumped;
+    // ... last bumped, also by votes on several message handler threads
+    std::atomic<int64_t> nTimeLastBumped;
     // ... or failed
     int64_t nTimeLastFailure;
 
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <thread>
 #include <memory>
+#include <set>
 #include <condition_variable>
 
 #ifndef WIN32
@@ -58,6 +59,8 @@ static const unsigned int MAX_INV_SZ = 50000;
 static const unsigned int MAX_ADDR_TO_SEND = 1000;
 /** Maximum length of incoming protocol messages (no message over 3 MiB is currently acceptable). */
 static const unsigned int MAX_PROTOCOL_MESSAGE_LENGTH = 3 * 1024 * 1024;
+/** Size of the socket handler's receive buffer, the data of larger messages is received in place */
+static const unsigned int RECV_BUFFER_SIZE = 0x10000;
 /** Maximum length of strSubVer in `version` message */
 static const unsigned int MAX_SUBVERSION_LENGTH = 256;
 /** Maximum number of automatic outgoing nodes */
@@ -91,6 +94,18 @@ static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
+/** -msghandlers default and maximum: threads processing peer messages, each owning a share of the peers */
+static const int DEFAULT_MSGHANDLER_THREADS = 4;
+static const int MAX_MSGHANDLER_THREADS = 16;
+/** How long the socket handler waits for socket events before it checks disconnects and timeouts */
+static const int SOCKET_EVENTS_TIMEOUT_MILLISECONDS = 50;
+/** -socketevents default, select() is the fallback on platforms without epoll */
+#ifdef HAVE_SYS_EPOLL_H
+static const char* const DEFAULT_SOCKETEVENTS = "epoll";
+#else
+static const char* const DEFAULT_SOCKETEVENTS = "select";
+#endif
+
 static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
@@ -135,6 +150,11 @@ public:
         CONNECTIONS_ALL = (CONNECTIONS_IN | CONNECTIONS_OUT),
     };
 
+    enum SocketEventsMode {
+        SOCKETEVENTS_SELECT = 0,
+        SOCKETEVENTS_EPOLL = 1,
+    };
+
     struct Options
     {
         ServiceFlags nLocalServices = NODE_NONE;
@@ -149,6 +169,8 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
+        SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nMessageHandlerThreads = 1;
     };
     CConnman(uint64_t seed0, uint64_t seed1);
     ~CConnman();
@@ -409,8 +431,20 @@ private:
     void ThreadOpenAddedConnections();
     void ProcessOneShot();
     void ThreadOpenConnections();
-    void ThreadMessageHandler();
+    /** Process the messages of the peers with GetId() % nMessageHandlerThreads == nWorker */
+    void ThreadMessageHandler(int nWorker);
     void AcceptConnection(const ListenSocket& hListenSocket);
+    /** Wait for sockets to become readable or writable, false if interrupted */
+    bool SocketEvents(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set);
+    bool SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set);
+#ifdef HAVE_SYS_EPOLL_H
+    bool SocketEventsEpoll(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set);
+#endif
+    /** Add a new node's socket to the epoll set */
+    void RegisterSocketEvents(CNode* pnode);
+    /** Wait for the node's socket to become writable while vSendMsg is not empty,
+     *  otherwise for it to become readable unless receiving is paused (epoll only) */
+    void UpdateSocketEvents(CNode* pnode) const;
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
@@ -469,6 +503,8 @@ private:
     unsigned int nReceiveFloodSize;
 
     std::vector<ListenSocket> vhListenSocket;
+    SocketEventsMode socketEventsMode;
+    int epollfd;
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
     CCriticalSection cs_setBanned;
@@ -505,8 +541,9 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake;
+    /** flags for waking the message processors, one per thread */
+    std::vector<bool> vMsgProcWake;
+    int nMessageHandlerThreads;
 
     std::condition_variable condMsgProc;
     std::mutex mutexMsgProc;
@@ -519,7 +556,7 @@ private:
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadOpenMasternodeConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> threadMessageHandlers;
 };
 extern std::unique_ptr<CConnman> g_connman;
 void Discover(boost::thread_group& threadGroup);
@@ -620,6 +657,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdSize mapRecvTimePerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -672,6 +710,11 @@ public:
 
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
+
+    /** Make room for the next data bytes and return where they go, nSpace of them at most */
+    char* PrepareData(unsigned int& nSpace);
+    /** Account nBytes written to the room returned by PrepareData */
+    void CommitData(unsigned int nBytes);
 };
 
 
@@ -684,6 +727,7 @@ public:
     std::atomic<ServiceFlags> nServices;
     ServiceFlags nServicesExpected;
     SOCKET hSocket;
+    uint32_t nSocketEvents; // epoll events hSocket is registered for, guarded by cs_hSocket
     size_t nSendSize; // total size of all vSendMsg entries
     size_t nSendOffset; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
@@ -747,6 +791,9 @@ protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdSize mapRecvTimePerMsgCmd; // microseconds spent processing, guarded by cs_vProcessMsg
+
+    void CompleteMessage(CNetMessage& msg, int64_t nTimeMicros);
 
 public:
     uint256 hashContinue;
@@ -840,6 +887,14 @@ public:
     }
 
     bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete);
+    /**
+     * Where the rest of a message of RECV_BUFFER_SIZE or more bytes can be received
+     * straight into its data, NULL when the next bytes are not part of one.
+     * Only the socket handler may call this and ReceiveMsgBytesInPlace.
+     */
+    char* GetReceiveBuffer(unsigned int& nSpace);
+    void ReceiveMsgBytesInPlace(unsigned int nBytes, bool& complete);
+    void RecordProcessTime(const std::string& strCommand, int64_t nTimeMicros);
 
     void SetRecvVersion(int nVersionIn)
     {
@@ -13,13 +13,16 @@
 #include "blockencodings.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
+#include "documentfilter.h"
 #include "hash.h"
+#include "headerhash.h"
 #include "init.h"
 #include "validation.h"
 #include "merkleblock.h"
 #include "net.h"
 #include "netmessagemaker.h"
 #include "netbase.h"
+#include "netstats.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
 #include "primitives/block.h"
@@ -84,6 +87,16 @@ static const uint64_t RANDOMIZER_ID_ADDRESS_RELAY = 0x3cac0035b5866b90ULL; // SH
 
 // Internal stuff
 namespace {
+    /**
+     * Held while processing every message not in IsParallelMessage, while
+     * serving getdata and while sending, so that only those messages run
+     * concurrently on the message handler threads. Serving getdata reads
+     * mapRelay and the masternode managers' maps, and sending drains
+     * vAddrToSend, which addr relay fills for other peers without a lock.
+     * Lock order: before cs_main.
+     */
+    CCriticalSection cs_serialMessages;
+
     /** Number of nodes with fSyncStarted. */
     int nSyncStarted = 0;
 
@@ -1359,6 +1372,54 @@ inline void static SendBlockTransactions(const CBlock& block, const BlockTransac
     connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCKTXN, resp));
 }
 
+/** Validate a getdocfilt/getdocfhdrs range, returns the stop block or NULL after disconnecting the peer */
+static const CBlockIndex* PrepareDocumentFilterRequest(CNode* pfrom, uint32_t nStartHeight, const uint256& stopHash,
+                                                       unsigned int nMaxRange) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    if (!(pfrom->GetLocalServices() & NODE_DOCFILTERS)) {
+        LogPrint("net", "document filter request with the filter index disabled, disconnect peer=%d\n", pfrom->GetId());
+        pfrom->fDisconnect = true;
+        return NULL;
+    }
+
+    BlockMap::iterator mi = mapBlockIndex.find(stopHash);
+    if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second)) {
+        LogPrint("net", "document filter request for unknown or stale block %s, disconnect peer=%d\n", stopHash.ToString(), pfrom->GetId());
+        pfrom->fDisconnect = true;
+        return NULL;
+    }
+
+    const CBlockIndex* pindexStop = mi->second;
+    if (nStartHeight > (uint32_t)pindexStop->nHeight || pindexStop->nHeight - nStartHeight >= nMaxRange) {
+        LogPrint("net", "document filter request with invalid range %u-%d, disconnect peer=%d\n", nStartHeight, pindexStop->nHeight, pfrom->GetId());
+        pfrom->fDisconnect = true;
+        return NULL;
+    }
+    return pindexStop;
+}
+
+/**
+ * Messages whose handlers touch only the sending peer, locked state or the
+ * block index under cs_main, and may be processed by several message handler
+ * threads at once. Everything else is serialized by cs_serialMessages.
+ * The spork, InstantSend vote and governance vote handlers keep their maps
+ * under their own lock and are called directly, see ProcessMessage. addr
+ * stays serial: its relay writes to other peers' vAddrToSend and addrKnown.
+ */
+static bool IsParallelMessage(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::PING ||
+           strCommand == NetMsgType::PONG ||
+           strCommand == NetMsgType::GETDOCFILTERS ||
+           strCommand == NetMsgType::GETDOCFHEADERS ||
+           strCommand == NetMsgType::GETMNLISTDIFF ||
+           strCommand == NetMsgType::MNLISTDIFF ||
+           strCommand == NetMsgType::SPORK ||
+           strCommand == NetMsgType::GETSPORKS ||
+           strCommand == NetMsgType::TXLOCKVOTE ||
+           strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE;
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
     LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
@@ -2558,6 +2619,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Hash all headers in parallel before taking cs_main
+        std::vector<uint256> hashes = HashBlockHeaders(headers);
+
         const CBlockIndex *pindexLast = NULL;
         {
         LOCK(cs_main);
@@ -2575,14 +2639,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             nodestate->nUnconnectingHeaders++;
             connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
             LogPrint("net", "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    hashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->id, nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom->GetId(), hashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom->GetId(), 20);
@@ -2591,17 +2655,17 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         }
 
         uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            if (!hashLastBlock.IsNull() && headers[i].hashPrevBlock != hashLastBlock) {
                 Misbehaving(pfrom->GetId(), 20);
                 return error("non-continuous headers sequence");
             }
-            hashLastBlock = header.GetHash();
+            hashLastBlock = hashes[i];
         }
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, hashes, state, chainparams, &pindexLast)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
@@ -2954,6 +3018,84 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     }
 
 
+    else if (strCommand == NetMsgType::GETDOCFILTERS) {
+        uint32_t nStartHeight;
+        uint256 stopHash;
+        vRecv >> nStartHeight >> stopHash;
+
+        LOCK(cs_main);
+        const CBlockIndex* pindexStop = PrepareDocumentFilterRequest(pfrom, nStartHeight, stopHash, MAX_GETDOCFILTERS_SIZE);
+        if (!pindexStop)
+            return true;
+
+        std::vector<const CBlockIndex*> vBlocks;
+        for (const CBlockIndex* pindex = pindexStop; pindex && pindex->nHeight >= (int)nStartHeight; pindex = pindex->pprev)
+            vBlocks.push_back(pindex);
+
+        for (auto it = vBlocks.rbegin(); it != vBlocks.rend(); ++it) {
+            CDocumentFilter filter;
+            uint256 header;
+            if (!GetDocumentFilter(*it, filter, header)) {
+                LogPrint("net", "no document filter for block %s, peer=%d\n", (*it)->GetBlockHash().ToString(), pfrom->GetId());
+                break;
+            }
+            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DOCFILTER, filter.GetBlockHash(), filter.GetEncoded()));
+        }
+    }
+
+
+    else if (strCommand == NetMsgType::GETDOCFHEADERS) {
+        uint32_t nStartHeight;
+        uint256 stopHash;
+        vRecv >> nStartHeight >> stopHash;
+
+        LOCK(cs_main);
+        const CBlockIndex* pindexStop = PrepareDocumentFilterRequest(pfrom, nStartHeight, stopHash, MAX_GETDOCFHEADERS_SIZE);
+        if (!pindexStop)
+            return true;
+
+        CDocumentFilter filter;
+        uint256 header, prevHeader;
+        std::vector<uint256> vFilterHashes(pindexStop->nHeight - nStartHeight + 1);
+        const CBlockIndex* pindex = pindexStop;
+        for (size_t i = vFilterHashes.size(); i > 0; i--, pindex = pindex->pprev) {
+            if (!GetDocumentFilter(pindex, filter, header)) {
+                LogPrint("net", "no document filter for block %s, peer=%d\n", pindex->GetBlockHash().ToString(), pfrom->GetId());
+                return true;
+            }
+            vFilterHashes[i - 1] = filter.GetHash();
+        }
+        if (pindex && !GetDocumentFilter(pindex, filter, prevHeader)) {
+            LogPrint("net", "no document filter for block %s, peer=%d\n", pindex->GetBlockHash().ToString(), pfrom->GetId());
+            return true;
+        }
+
+        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::DOCFHEADERS, stopHash, prevHeader, vFilterHashes));
+    }
+
+
+    else if (strCommand == NetMsgType::DOCFILTER || strCommand == NetMsgType::DOCFHEADERS) {
+        // we never request these, light clients do
+        LogPrint("net", "received not-requested %s. peer=%d\n", SanitizeString(strCommand), pfrom->id);
+    }
+
+
+    else if (strCommand == NetMsgType::SPORK || strCommand == NetMsgType::GETSPORKS) {
+        // only this handler, the others are serial
+        sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
+    }
+
+
+    else if (strCommand == NetMsgType::TXLOCKVOTE) {
+        instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    }
+
+
+    else if (strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE) {
+        governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    }
+
+
     else if (strCommand == NetMsgType::NOTFOUND) {
         // We do not care about the NOTFOUND message, but logging an Unknown Command
         // message would be undesirable as we transmit it ourselves.
@@ -3038,8 +3180,10 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
     //
     bool fMoreWork = false;
 
-    if (!pfrom->vRecvGetData.empty())
+    if (!pfrom->vRecvGetData.empty()) {
+        LOCK(cs_serialMessages);
         ProcessGetData(pfrom, chainparams.GetConsensus(), connman, interruptMsgProc);
+    }
 
     if (pfrom->fDisconnect)
         return false;
@@ -3098,9 +3242,16 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
 
         // Process message
         bool fRet = false;
+        int64_t nTimeStart = GetTimeMicros();
+        int64_t nCsMainWaitStart = GetThreadCsMainWait();
         try
         {
-            fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            if (IsParallelMessage(strCommand)) {
+                fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            } else {
+                LOCK(cs_serialMessages);
+                fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            }
             if (interruptMsgProc)
                 return false;
             if (!pfrom->vRecvGetData.empty())
@@ -3135,6 +3286,11 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
             PrintExceptionContinue(NULL, "ProcessMessages()");
         }
 
+        int64_t nTimeProcess = GetTimeMicros() - nTimeStart;
+        pfrom->RecordProcessTime(strCommand, nTimeProcess);
+        netStats.RecordMessage(strCommand, nMessageSize, nTimeProcess, GetThreadCsMainWait() - nCsMainWaitStart);
+        LogPrint("bench", "    - Process %s (%u bytes) peer=%d: %.2fms\n", SanitizeString(strCommand), nMessageSize, pfrom->id, nTimeProcess * 0.001);
+
         if (!fRet) {
             LogPrintf("%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->id);
         }
@@ -3170,6 +3326,8 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
         if (!pto->fSuccessfullyConnected || pto->fDisconnect)
             return true;
 
+        LOCK(cs_serialMessages);
+
         // If we get here, the outgoing message serialization version is set and can't change.
         const CNetMsgMaker msgMaker(pto->GetSendVersion());
 
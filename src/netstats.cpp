@@ -0,0 +1,87 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "netstats.h"
+
+#include "protocol.h"
+
+#include <algorithm>
+#include <string.h>
+
+CNetStats netStats;
+
+int CTimeHistogram::GetBucket(int64_t nMicros)
+{
+    if (nMicros < 4)
+        return std::max<int64_t>(nMicros, 0);
+    int nMsb = 63;
+    while (!(nMicros >> nMsb))
+        nMsb--;
+    return (nMsb - 1) * 4 + ((nMicros >> (nMsb - 2)) & 3);
+}
+
+int64_t CTimeHistogram::GetBucketUpperBound(int nBucket)
+{
+    if (nBucket < 4)
+        return nBucket;
+    int nShift = nBucket / 4 - 1;
+    return ((int64_t)(4 + nBucket % 4) << nShift) - 1 + ((int64_t)1 << nShift);
+}
+
+void CTimeHistogram::Add(int64_t nMicros)
+{
+    vBuckets[GetBucket(nMicros)]++;
+    nCount++;
+    nTotal += nMicros;
+    nMax = std::max(nMax, nMicros);
+}
+
+void CTimeHistogram::Clear()
+{
+    memset(vBuckets, 0, sizeof(vBuckets));
+    nCount = 0;
+    nTotal = 0;
+    nMax = 0;
+}
+
+int64_t CTimeHistogram::GetPercentile(double dPercentile) const
+{
+    if (nCount == 0)
+        return 0;
+    // rank of the sample, counted from 1
+    uint64_t nRank = std::max<uint64_t>(1, (uint64_t)(dPercentile / 100 * nCount + 0.5));
+    uint64_t nSeen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        nSeen += vBuckets[i];
+        if (nSeen >= nRank)
+            return std::min(GetBucketUpperBound(i), nMax);
+    }
+    return nMax;
+}
+
+void CNetStats::RecordMessage(const std::string& strCommand, unsigned int nBytes, int64_t nTimeProcess, int64_t nLockWait)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    auto it = mapCommandStats.find(strCommand);
+    if (it == mapCommandStats.end()) {
+        // to prevent a memory DoS, only valid commands get their own entry
+        const std::vector<std::string>& vTypes = getAllNetMessageTypes();
+        bool fKnown = std::find(vTypes.begin(), vTypes.end(), strCommand) != vTypes.end();
+        it = mapCommandStats.emplace(fKnown ? strCommand : "*other*", CNetCommandStats()).first;
+    }
+    it->second.nBytes += nBytes;
+    it->second.timeProcess.Add(nTimeProcess);
+    it->second.nLockWait += nLockWait;
+}
+
+std::map<std::string, CNetCommandStats> CNetStats::GetCommandStats(bool fReset)
+{
+    std::map<std::string, CNetCommandStats> mapRet;
+    std::lock_guard<std::mutex> lock(cs);
+    if (fReset)
+        mapRet.swap(mapCommandStats);
+    else
+        mapRet = mapCommandStats;
+    return mapRet;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DMS_NETSTATS_H
+#define DMS_NETSTATS_H
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Histogram of durations in microseconds with four buckets per power of two,
+ * so percentiles are exact up to 7 and within 25% above.
+ */
+class CTimeHistogram
+{
+public:
+    static const int NUM_BUCKETS = 248;
+
+private:
+    uint64_t vBuckets[NUM_BUCKETS];
+    uint64_t nCount;
+    int64_t nTotal;
+    int64_t nMax;
+
+    static int GetBucket(int64_t nMicros);
+    static int64_t GetBucketUpperBound(int nBucket);
+
+public:
+    CTimeHistogram() { Clear(); }
+
+    void Add(int64_t nMicros);
+    void Clear();
+
+    uint64_t GetCount() const { return nCount; }
+    int64_t GetTotal() const { return nTotal; }
+    int64_t GetMax() const { return nMax; }
+    /** Upper bound of the bucket holding the given percentile (0-100), at most the maximum */
+    int64_t GetPercentile(double dPercentile) const;
+};
+
+/** Processing statistics of one P2P command, summed over all peers */
+struct CNetCommandStats
+{
+    uint64_t nBytes = 0;
+    CTimeHistogram timeProcess;
+    int64_t nLockWait = 0;
+};
+
+/** Per command processing statistics, fed by the message handler threads */
+class CNetStats
+{
+private:
+    std::mutex cs;
+    std::map<std::string, CNetCommandStats> mapCommandStats;
+
+public:
+    /** Account a processed message, commands unknown to the protocol are summed up as "*other*" */
+    void RecordMessage(const std::string& strCommand, unsigned int nBytes, int64_t nTimeProcess, int64_t nLockWait);
+    /** Copy of the statistics, with fReset cleared in the same step so that no message is lost or counted twice */
+    std::map<std::string, CNetCommandStats> GetCommandStats(bool fReset = false);
+};
+
+extern CNetStats netStats;
+
+#endif // DMS_NETSTATS_H
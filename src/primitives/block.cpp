@@ -12,6 +12,43 @@
 #include "utilstrencodings.h"
 #include "crypto/common.h"
 
+#include <atomic>
+#include <string.h>
+
+static const size_t BLOCK_HEADER_SIZE = 80;
+
+static std::atomic<uint64_t> nHashCalls(0);
+static std::atomic<uint64_t> nHashComputations(0);
+
+struct CBlockHeader::CachedHash
+{
+    unsigned char header[BLOCK_HEADER_SIZE];
+    uint256 hash;
+};
+
+CBlockHeader::CBlockHeader(const CBlockHeader& other) :
+    nVersion(other.nVersion),
+    hashPrevBlock(other.hashPrevBlock),
+    hashMerkleRoot(other.hashMerkleRoot),
+    nTime(other.nTime),
+    nBits(other.nBits),
+    nNonce(other.nNonce),
+    cachedHash(std::atomic_load(&other.cachedHash))
+{
+}
+
+CBlockHeader& CBlockHeader::operator=(const CBlockHeader& other)
+{
+    nVersion = other.nVersion;
+    hashPrevBlock = other.hashPrevBlock;
+    hashMerkleRoot = other.hashMerkleRoot;
+    nTime = other.nTime;
+    nBits = other.nBits;
+    nNonce = other.nNonce;
+    std::atomic_store(&cachedHash, std::atomic_load(&other.cachedHash));
+    return *this;
+}
+
 uint256 CBlockHeader::GetHash() const
 {
     /** Bitcoin
@@ -23,8 +60,38 @@ uint256 CBlockHeader::GetHash() const
     ss << *this;
     return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
     */
-    /** Documentchain */
-    return SerializeHashYescrypt(*this);
+    /** Documentchain: same as SerializeHashYescrypt(*this), but memoized */
+    nHashCalls.fetch_add(1, std::memory_order_relaxed);
+
+    // the serialized header, written by hand so that a cache hit does not allocate
+    unsigned char header[BLOCK_HEADER_SIZE];
+    WriteLE32(header, nVersion);
+    memcpy(header + 4, hashPrevBlock.begin(), 32);
+    memcpy(header + 36, hashMerkleRoot.begin(), 32);
+    WriteLE32(header + 68, nTime);
+    WriteLE32(header + 72, nBits);
+    WriteLE32(header + 76, nNonce);
+
+    std::shared_ptr<const CachedHash> cached = std::atomic_load(&cachedHash);
+    if (cached && memcmp(cached->header, header, BLOCK_HEADER_SIZE) == 0)
+        return cached->hash;
+
+    nHashComputations.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<CachedHash> entry = std::make_shared<CachedHash>();
+    memcpy(entry->header, header, BLOCK_HEADER_SIZE);
+    yescrypt_hash((const char*)entry->header, (char*)entry->hash.begin());
+    std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>(entry));
+    return entry->hash;
+}
+
+uint64_t CBlockHeader::GetHashCalls()
+{
+    return nHashCalls.load();
+}
+
+uint64_t CBlockHeader::GetHashComputations()
+{
+    return nHashComputations.load();
 }
 
 std::string CBlock::ToString() const
@@ -10,6 +10,8 @@
 #include "serialize.h"
 #include "uint256.h"
 
+#include <memory>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -28,11 +30,23 @@ public:
     uint32_t nBits;
     uint32_t nNonce;
 
+private:
+    // memory only: the last computed hash, together with the serialized header it belongs to.
+    // Any change of the header fields makes it stale, so the fields can still be modified directly.
+    struct CachedHash;
+    mutable std::shared_ptr<const CachedHash> cachedHash;
+
+public:
     CBlockHeader()
     {
         SetNull();
     }
 
+    CBlockHeader(const CBlockHeader& other);
+    CBlockHeader& operator=(const CBlockHeader& other);
+    CBlockHeader(CBlockHeader&& other) = default;
+    CBlockHeader& operator=(CBlockHeader&& other) = default;
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -53,6 +67,7 @@ public:
         nTime = 0;
         nBits = 0;
         nNonce = 0;
+        std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>());
     }
 
     bool IsNull() const
@@ -60,8 +75,13 @@ public:
         return (nBits == 0);
     }
 
+    // The yescrypt hash is only computed again if the header has changed since the last call
     uint256 GetHash() const;
 
+    /** Process wide number of GetHash calls and of the yescrypt runs they needed, for tests */
+    static uint64_t GetHashCalls();
+    static uint64_t GetHashComputations();
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
@@ -106,14 +126,8 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        block.hashPrevBlock  = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime          = nTime;
-        block.nBits          = nBits;
-        block.nNonce         = nNonce;
-        return block;
+        // also copies the cached hash
+        return CBlockHeader(*this);
     }
 
     std::string ToString() const;
@@ -4,6 +4,7 @@
 
 #include "primitives/document.h"
 #include "tinyformat.h"
+#include "utilstrencodings.h"
 
 /** CDocumentHash
  */
@@ -24,7 +25,7 @@ void CDocumentHash::SetNull()
     hash = "";
 }
 
-bool CDocumentHash::SameHash(CDocumentHash comparewith, bool allowempty/*=false*/)
+bool CDocumentHash::SameHash(const CDocumentHash& comparewith, bool allowempty/*=false*/) const
 {
     if (!allowempty && (hash.empty() || algo < 0))
         return false;
@@ -32,7 +33,7 @@ bool CDocumentHash::SameHash(CDocumentHash comparewith, bool allowempty/*=false*
     return (hash == comparewith.hash && algo == comparewith.algo);
 }
 
-std::string CDocumentHash::AlgoName()
+std::string CDocumentHash::AlgoName() const
 {
     switch (algo) {
         case  0: return "MD5"; // GUID/MD5
@@ -49,64 +50,143 @@ std::string CDocumentHash::AlgoName()
     }
 }
 
-/** CDocument
+/** CDocumentRef
  */
-CDocument::CDocument() {
-    SetNull();
+void CDocumentRef::SetNull()
+{
+    pbegin = nullptr;
+    pend = nullptr;
+    version = 0;
+    guid = CDocumentHashRef();
+    indexhash = CDocumentHashRef();
+    filehash = CDocumentHashRef();
+    attrhash = CDocumentHashRef();
+    ownerhash = CDocumentHashRef();
+    merkleroot = CDocumentHashRef();
+    merklecount = 0;
 }
 
-CDocument::CDocument(std::string rawDoc)
+/*
+ Binary layout, all versions: "DM$" <version, 2 bytes> <app id, 2 bytes> <data>
+ version 1: GUID, MD5 file hash, MD5 attribute hash and optional MD5 owner hash, 16 bytes each
+ version 2: up to 19 entries <type << 4, 1 byte> <algo as two decimal digits, 1 byte> <hash>
+ version 3: <leaf count, 4 bytes big endian> <SHA-256 Merkle root, 32 bytes>
+*/
+bool CDocumentRef::Parse(const unsigned char* pbeginIn, const unsigned char* pendIn)
 {
     SetNull();
-    rawDocument = rawDoc; // "444d24..."
-    std::transform(rawDocument.begin(), rawDocument.end(), rawDocument.begin(), ::toupper);
-    if (rawDocument.length() < 42 || rawDocument.substr(0, 6) != "444D24")
-        return;
-
-    std::string sVersion = rawDocument.substr(6, 4);
-    if (sVersion == "0001") {
-        version = 1;
-        guidcompr = rawDocument.substr(14, 32);
-        filehash = CDocumentHash(0, rawDocument.substr(46, 32));
+    const size_t nSize = pendIn - pbeginIn;
+    if (nSize < 21 || pbeginIn[0] != 0x44 || pbeginIn[1] != 0x4D || pbeginIn[2] != 0x24)
+        return false;
+    pbegin = pbeginIn;
+    pend = pendIn;
+
+    version = (pbegin[3] << 8) | pbegin[4];
+    // a hash cut off at the end is left out, the hashes before it stay valid
+    if (version == 1) {
+        if (nSize < 39)
+            return false;
+        guid = CDocumentHashRef(0, pbegin + 7, 16);
+        filehash = CDocumentHashRef(0, pbegin + 23, 16);
         indexhash = filehash;
-        attrhash = CDocumentHash(0, rawDocument.substr(78, 32));
-        if (rawDocument.length() == 142)
-            ownerhash = CDocumentHash(0, rawDocument.substr(110, 32));
+        if (nSize >= 55)
+            attrhash = CDocumentHashRef(0, pbegin + 39, 16);
+        if (nSize == 71)
+            ownerhash = CDocumentHashRef(0, pbegin + 55, 16);
     }
-    else if (sVersion == "0002") {
-        version = 2;
-        int idx = 14;
-        int i = 0;
-        while (idx < rawDocument.length()) {
-            i++; // wrong data could cause an endless loop
-            if (i > 19)
-                throw("Invalid hash data");
-            char htype = rawDocument[idx];
-            int halgo = std::stoi(rawDocument.substr(idx+2, 2));
-            std::string hash = rawDocument.substr(idx+4, HashHexLength(halgo));
-            idx += 4 + HashHexLength(halgo);
-
-            switch (htype) {
-                case '0':
-                    guidcompr = hash;
-                    break;
-                case 'F':
-                    if (halgo == 0)
-                        indexhash = CDocumentHash(halgo, hash);
-                    else
-                        filehash = CDocumentHash(halgo, hash);
-                    break;
-                case 'A':
-                    attrhash = CDocumentHash(halgo, hash);
-                    break;
-                case 'B':
-                    ownerhash = CDocumentHash(halgo, hash);
+    else if (version == 2) {
+        const unsigned char* p = pbegin + 7;
+        for (int i = 0; p < pend; i++) {
+            if (i >= 19 || pend - p < 2)
+                return false;
+            const unsigned char type = p[0] >> 4;
+            if ((p[1] >> 4) > 9 || (p[1] & 0x0F) > 9)
+                return false;
+            const int algo = (p[1] >> 4) * 10 + (p[1] & 0x0F);
+            const size_t nHashSize = CDocument::HashHexLength(algo) / 2;
+            p += 2;
+            if ((size_t)(pend - p) < nHashSize)
+                break;
+            if (nHashSize > 0) {
+                CDocumentHashRef hash(algo, p, nHashSize);
+                switch (type) {
+                    case 0x0:
+                        guid = hash;
+                        break;
+                    case 0xF:
+                        if (algo == 0)
+                            indexhash = hash;
+                        else
+                            filehash = hash;
+                        break;
+                    case 0xA:
+                        attrhash = hash;
+                        break;
+                    case 0xB:
+                        ownerhash = hash;
+                }
             }
+            p += nHashSize;
         }
     }
+    else if (version == 3) {
+        if (nSize < 43)
+            return false;
+        merklecount = ((uint32_t)pbegin[7] << 24) | ((uint32_t)pbegin[8] << 16) | ((uint32_t)pbegin[9] << 8) | pbegin[10];
+        merkleroot = CDocumentHashRef(22, pbegin + 11, 32);
+    }
+    return true;
+}
+
+/** CDocument
+ */
+CDocument::CDocument() {
+    SetNull();
+}
+
+CDocument::CDocument(std::string rawDoc)
+{
+    SetNull();
+    std::vector<unsigned char> data = ParseHex(rawDoc); // "444d24..."
+    CDocumentRef ref;
+    if (ref.Parse(data.data(), data.data() + data.size()))
+        *this = CDocument(ref);
+}
+
+// Hashes are kept in upper case hex, as written by the wallet
+static std::string UpperHex(const unsigned char* pbegin, const unsigned char* pend)
+{
+    static const char hexmap[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+    std::string str(2 * (pend - pbegin), '0');
+    for (size_t i = 0; pbegin != pend; ++pbegin) {
+        str[i++] = hexmap[*pbegin >> 4];
+        str[i++] = hexmap[*pbegin & 15];
+    }
+    return str;
+}
+
+static CDocumentHash HashRefToHash(const CDocumentHashRef& ref)
+{
+    if (ref.IsNull())
+        return CDocumentHash();
+    return CDocumentHash(ref.algo, UpperHex(ref.begin(), ref.end()));
+}
+
+CDocument::CDocument(const CDocumentRef& ref)
+{
+    SetNull();
+    rawDocument = UpperHex(ref.pbegin, ref.pend);
+    version = ref.version;
+    guidcompr = HashRefToHash(ref.guid).hash;
+    indexhash = HashRefToHash(ref.indexhash);
+    filehash = HashRefToHash(ref.filehash);
+    attrhash = HashRefToHash(ref.attrhash);
+    ownerhash = HashRefToHash(ref.ownerhash);
+    merkleroot = HashRefToHash(ref.merkleroot);
+    merklecount = ref.merklecount;
 
-    if (!guidcompr.empty())
-        guid = strprintf("{%s-%s-%s-%s-%s}", guidcompr.substr(0, 8), guidcompr.substr(8, 4), 
+    if (guidcompr.length() == 32)
+        guid = strprintf("{%s-%s-%s-%s-%s}", guidcompr.substr(0, 8), guidcompr.substr(8, 4),
                   guidcompr.substr(12, 4), guidcompr.substr(16, 4), guidcompr.substr(20, 12));
     isvalid = true;
 }
@@ -121,6 +201,8 @@ void CDocument::SetNull()
     filehash.SetNull();
     attrhash.SetNull();
     ownerhash.SetNull();
+    merkleroot.SetNull();
+    merklecount = 0;
 }
 
 int CDocument::HashHexLength(int algo)
@@ -5,6 +5,8 @@
 #ifndef BITCOIN_PRIMITIVES_DOCUMENT_H
 #define BITCOIN_PRIMITIVES_DOCUMENT_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <iostream>
 
 class CDocumentHash
@@ -18,15 +20,52 @@ public:
     CDocumentHash(int aalgo, std::string ahash);
 
     void SetNull();
-    bool SameHash(CDocumentHash comparewith, bool allowempty = false);
-    std::string AlgoName();
+    bool SameHash(const CDocumentHash& comparewith, bool allowempty = false) const;
+    std::string AlgoName() const;
+};
+
+/** Hash inside a DM$ payload, points into the parsed script */
+struct CDocumentHashRef
+{
+    int algo;
+    const unsigned char* data;
+    size_t size;
+
+    CDocumentHashRef() : algo(-1), data(nullptr), size(0) {}
+    CDocumentHashRef(int aalgo, const unsigned char* adata, size_t asize) : algo(aalgo), data(adata), size(asize) {}
+
+    bool IsNull() const { return data == nullptr; }
+    const unsigned char* begin() const { return data; }
+    const unsigned char* end() const { return data + size; }
+};
+
+/** DM$ payload parsed in place: no allocations, no exceptions.
+ *  The hashes are only valid as long as the parsed buffer. */
+class CDocumentRef
+{
+public:
+    const unsigned char* pbegin;  // the parsed payload
+    const unsigned char* pend;
+    int version;
+    CDocumentHashRef guid;
+    CDocumentHashRef indexhash;
+    CDocumentHashRef filehash;
+    CDocumentHashRef attrhash;
+    CDocumentHashRef ownerhash;
+    CDocumentHashRef merkleroot;  // version 3: root of a document batch
+    uint32_t merklecount;         // version 3: number of documents in the batch
+
+    CDocumentRef() { SetNull(); }
+
+    void SetNull();
+    /** Parse the payload starting with "DM$", false if it is not a valid document */
+    bool Parse(const unsigned char* pbegin, const unsigned char* pend);
 };
 
 class CDocument
 {
 private:
     void SetNull();
-    int HashHexLength(int algo);
 public:
     int version;
     bool isvalid;
@@ -37,9 +76,15 @@ public:
     CDocumentHash filehash;
     CDocumentHash attrhash;
     CDocumentHash ownerhash;
+    CDocumentHash merkleroot;  // version 3: root of a document batch
+    unsigned int merklecount;  // version 3: number of documents in the batch
 
     CDocument();
     CDocument(std::string rawDoc);
+    CDocument(const CDocumentRef& ref);
+
+    /** Length of a hash in hex digits for the given algorithm id, 0 if unknown */
+    static int HashHexLength(int algo);
 };
 
 #endif // BITCOIN_PRIMITIVES_DOCUMENT_H
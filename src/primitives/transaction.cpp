@@ -11,6 +11,8 @@
 #include "utilstrencodings.h"
 #include "primitives/document.h"
 
+#include <algorithm>
+
 std::string COutPoint::ToString() const
 {
     return strprintf("COutPoint(%s, %u)", hash.ToString()/*.substr(0,10)*/, n);
@@ -57,37 +59,49 @@ CTxOut::CTxOut(const CAmount& nValueIn, CScript scriptPubKeyIn, int nRoundsIn)
     nRounds = nRoundsIn;
 }
 
-bool CTxOut::GetDocument(std::string& guid, std::string& indexhash, std::string& filehash, std::string& attrhash) const
+/*
+ revision v2, BIP34 disabled: scriptPubKey = OP_RETURN <push> "DM$..."
+ revision v2, BIP34 enabled : scriptPubKey = OP_RETURN OP_PUSHDATA1 <length> "DM$..."
+ The payload starts at the first "DM$" after the push opcode and runs to the end of the script.
+*/
+static const unsigned char* FindDocumentPayload(const CScript& script)
 {
-    if (scriptPubKey[0] != OP_RETURN)
-        return false;
+    static const unsigned char magic[3] = {0x44, 0x4D, 0x24};
+    if (script.size() < 2 || script[0] != OP_RETURN)
+        return nullptr;
+
+    const unsigned char* pend = script.data() + script.size();
+    const unsigned char* p = std::search(script.data() + 2, pend, magic, magic + sizeof(magic));
+    return p == pend ? nullptr : p;
+}
+
+bool CTxOut::GetDocumentRef(CDocumentRef& ref) const
+{
+    const unsigned char* pbegin = FindDocumentPayload(scriptPubKey);
+    return pbegin && ref.Parse(pbegin, scriptPubKey.data() + scriptPubKey.size());
+}
 
-    std::string rawDocument = HexStr(scriptPubKey.begin() + 2, scriptPubKey.end());
-    /*
-    revision v2, BIP34 disabled: rawDocument = "444d24..."
-    revision v2, BIP34 enabled : rawDocument = "7d444d24..."
-    The longer data in revision v2 contains the OP_PUSHDATA1 etc, skip it
-    Alternative: rawDocument = ScriptToAsmStr(scriptPubKey) = "OP_RETURN 444d24..."
-    */
-    size_t pos = rawDocument.find("444d24");
-    if (pos > 0)
-        rawDocument = rawDocument.substr(pos, std::string::npos);
-
-    if (rawDocument.substr(0, 6) != "444d24")
+bool CTxOut::GetDocument(CDocument& document) const
+{
+    CDocumentRef ref;
+    if (!GetDocumentRef(ref))
         return false;
 
-    try { // incompatible or (maliciously) wrong data can cause an exception
-        CDocument document(rawDocument);
-        if (document.isvalid) {
-            guid = document.guid;
-            indexhash = document.indexhash.hash;
-            filehash = document.filehash.hash;
-            attrhash = document.attrhash.hash;
-        }
-        return document.isvalid;
-    } catch (...) {
+    document = CDocument(ref);
+    return true;
+}
+
+bool CTxOut::GetDocument(std::string& guid, std::string& indexhash, std::string& filehash, std::string& attrhash) const
+{
+    CDocument document;
+    if (!GetDocument(document))
         return false;
-    }
+
+    guid = document.guid;
+    indexhash = document.indexhash.hash;
+    filehash = document.filehash.hash;
+    attrhash = document.attrhash.hash;
+    return true;
 }
 
 std::string CTxOut::ToString() const
@@ -129,7 +143,7 @@ uint256 CTransaction::ComputeHash() const
 /* For backward compatibility, the hash is initialized to 0. TODO: remove the need for this default constructor entirely. */
 CTransaction::CTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(TRANSACTION_NORMAL), vin(), vout(), nLockTime(0), hash() {}
 CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()) {}
-CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()) {}
+CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), vExtraPayload(std::move(tx.vExtraPayload)), hash(ComputeHash()) {}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -12,6 +12,9 @@
 #include "serialize.h"
 #include "uint256.h"
 
+class CDocument;
+class CDocumentRef;
+
 /** Transaction types */
 enum {
     TRANSACTION_NORMAL = 0,
@@ -209,6 +212,9 @@ public:
         return !(a == b);
     }
 
+    /** Parse the document of an OP_RETURN output in place, ref points into scriptPubKey */
+    bool GetDocumentRef(CDocumentRef& ref) const;
+    bool GetDocument(CDocument& document) const;
     bool GetDocument(std::string& guid, std::string& indexhash, std::string& filehash, std::string& attrhash) const;
 
     std::string ToString() const;
@@ -76,6 +76,10 @@ const char *MNLISTDIFF="mnlistdiff";
 const char *QFCOMMITMENT="qfcommit";
 const char *QDCOMMITMENT="qdcommit";
 const char *QCONTRIB="qcontrib";
+const char *GETDOCFILTERS="getdocfilt";
+const char *DOCFILTER="docfilter";
+const char *GETDOCFHEADERS="getdocfhdrs";
+const char *DOCFHEADERS="docfheaders";
 };
 
 static const char* ppszTypeName[] =
@@ -168,6 +172,10 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::QFCOMMITMENT,
     NetMsgType::QDCOMMITMENT,
     NetMsgType::QCONTRIB,
+    NetMsgType::GETDOCFILTERS,
+    NetMsgType::DOCFILTER,
+    NetMsgType::GETDOCFHEADERS,
+    NetMsgType::DOCFHEADERS,
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
 
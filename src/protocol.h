@@ -275,6 +275,26 @@ extern const char *MNLISTDIFF;
 extern const char *QFCOMMITMENT;
 extern const char *QDCOMMITMENT;
 extern const char *QCONTRIB;
+/**
+ * Contains a start height and a stop hash, the peer answers with one
+ * "docfilter" per block of the range (NODE_DOCFILTERS only).
+ */
+extern const char *GETDOCFILTERS;
+/**
+ * Contains a block hash and the encoded document filter of that block.
+ */
+extern const char *DOCFILTER;
+/**
+ * Contains a start height and a stop hash, the peer answers with a
+ * "docfheaders" message (NODE_DOCFILTERS only).
+ */
+extern const char *GETDOCFHEADERS;
+/**
+ * Contains the stop hash, the filter header of the block before the range
+ * and the hashes of the filters in the range, from which the client derives
+ * the filter headers.
+ */
+extern const char *DOCFHEADERS;
 };
 
 /* Get a vector of all valid message types (see above) */
@@ -299,6 +319,10 @@ enum ServiceFlags : uint64_t {
     // NODE_XTHIN means the node supports Xtreme Thinblocks
     // If this is turned off then the node will not service nor make xthin requests
     NODE_XTHIN = (1 << 4),
+    // NODE_DOCFILTERS means the node keeps a document filter index (-docfilterindex) and
+    // answers getdocfilt and getdocfhdrs, see documentfilter.h. Bit 6 is NODE_COMPACT_FILTERS
+    // of BIP 157, so the bit is taken from the range below until one is allocated.
+    NODE_DOCFILTERS = (1 << 24),
 
     // Bits 24-31 are reserved for temporary experiments. Just pick a bit that
     // isn't getting used, or one not being used much, and notify the
@@ -8,6 +8,7 @@
 
 #include "sync.h"
 #include "clientmodel.h"
+#include "documenthash.h"
 #include "walletmodel.h"
 #include "wallet/wallet.h"
 #include "init.h"
@@ -15,6 +16,7 @@
 #include "bitcoinunits.h"
 #include "optionsmodel.h"
 #include "util.h"
+#include "utilstrencodings.h"
 #include "guiutil.h"
 #include "rpcconsole.h"
 #include "transactionrecord.h"
@@ -82,17 +84,21 @@ QString getTextHash(const QString text, int algo)
     return QString::fromLatin1(hash.toHex()).toUpper();
 }
 
-QString getFileHash(const QString fileName, int algo)
+/** hashes of a file for several algorithms, the file is read only once, empty hashes if it cannot be read */
+QStringList getFileHashes(const QString fileName, const std::vector<int>& algos)
 {
-    QCryptographicHash crypto(getQtAlgo(algo));
-    QFile file(fileName);
-    file.open(QFile::ReadOnly);
-    while(!file.atEnd()){
-      crypto.addData(file.read(8192));
-    }
-    QByteArray hash = crypto.result();
+    CDocumentFileHashes file(QFile::encodeName(fileName).toStdString());
+    HashDocumentFile(file, algos);
 
-    return QString::fromLatin1(hash.toHex()).toUpper();
+    QStringList hashes;
+    for (size_t i = 0; i < algos.size(); i++)
+        hashes.append(i < file.vHashes.size() ? QString::fromStdString(HexStr(file.vHashes[i])).toUpper() : QString());
+    return hashes;
+}
+
+QString getFileHash(const QString fileName, int algo)
+{
+    return getFileHashes(fileName, {algo}).at(0);
 }
 
 QString compressGuid(QString GUID)
@@ -123,11 +129,12 @@ Document::Document(const QString docFileName)
         if (DOC_STORE_GUID)
             descFile.setValue("GUID", QUuid::createUuid().toString().toUpper());
         descFile.setValue("name", fileInfo.fileName());
+        QStringList hashes = getFileHashes(docFileName, {0, DOC_FILEHASH_ALGO});
         descFile.setValue("indexalgo", 0);
-        descFile.setValue("indexhash", getFileHash(docFileName, 0));
+        descFile.setValue("indexhash", hashes.at(0));
         descFile.setValue("filesize", fileInfo.size());
         descFile.setValue("filealgo", DOC_FILEHASH_ALGO);
-        descFile.setValue("filehash", getFileHash(docFileName, DOC_FILEHASH_ALGO));
+        descFile.setValue("filehash", hashes.at(1));
         if (DOC_ATTRHASH_ALGO > -1) {
             descFile.setValue("attralgo", DOC_ATTRHASH_ALGO);
             descFile.setValue("attrhash", getTextHash(attr, DOC_ATTRHASH_ALGO));
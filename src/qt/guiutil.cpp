@@ -1051,9 +1051,9 @@ QString formatServicesStr(quint64 mask)
 {
     QStringList strList;
 
-    // Just scan the last 8 bits for now.
-    for (int i = 0; i < 8; i++) {
-        uint64_t check = 1 << i;
+    // Just scan the last 32 bits for now.
+    for (int i = 0; i < 32; i++) {
+        uint64_t check = (uint64_t)1 << i;
         if (mask & check)
         {
             switch (check)
@@ -1070,6 +1070,9 @@ QString formatServicesStr(quint64 mask)
             case NODE_XTHIN:
                 strList.append("XTHIN");
                 break;
+            case NODE_DOCFILTERS:
+                strList.append("DOCFILTERS");
+                break;
             default:
                 strList.append(QString("%1[%2]").arg("UNKNOWN").arg(check));
             }
@@ -5,11 +5,16 @@
 
 #include "chain.h"
 #include "chainparams.h"
+#include "documentfilter.h"
+#include "merkleblock.h"
+#include "netstats.h"
 #include "primitives/block.h"
+#include "primitives/document.h"
 #include "primitives/transaction.h"
 #include "validation.h"
 #include "httpserver.h"
 #include "rpc/server.h"
+#include "spentindex.h"
 #include "streams.h"
 #include "sync.h"
 #include "txmempool.h"
@@ -404,6 +409,212 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_document(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    if (!fDocumentIndex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Document index not enabled (-documentindex)");
+
+    // an optional algorithm name in front of the hash, e.g. /rest/document/SHA3-256/<hash>
+    std::string algoStr;
+    std::string::size_type nSlash = hashStr.find('/');
+    if (nSlash != std::string::npos) {
+        algoStr = hashStr.substr(0, nSlash);
+        hashStr = hashStr.substr(nSlash + 1);
+        boost::to_upper(algoStr);
+    }
+
+    // without a name, every algorithm of the hash length is searched (SHA2 and SHA3 share lengths),
+    // 32 digits are an MD5 index hash or a GUID
+    std::vector<int> vAlgos;
+    for (int i = 0; i < 40; i++) {
+        if (CDocument::HashHexLength(i) == (int)hashStr.length() && (algoStr.empty() || CDocumentHash(i, "").AlgoName() == algoStr))
+            vAlgos.push_back(i);
+    }
+    if (vAlgos.empty() || !IsHex(hashStr))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + (algoStr.empty() ? hashStr : algoStr + "/" + hashStr));
+
+    CBlock block;
+    const CBlockIndex* pblockindex = NULL;
+    std::pair<CDocumentHashIndexKey, CDocumentIndexValue> entry;
+    int nConfirmations = 0;
+    {
+        // the index is read under the same lock as the chain, see verifydocuments
+        LOCK(cs_main);
+        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentList;
+        for (int algo : vAlgos) {
+            GetDocumentsByHash(DOCUMENT_HASH_FILE, algo, hashStr, documentList);
+            if (algo == 0)
+                GetDocumentsByHash(DOCUMENT_HASH_GUID, 0, hashStr, documentList);
+        }
+
+        // the earliest confirmed transaction proves the document, unconfirmed ones are skipped
+        for (const auto& item : documentList) {
+            if (item.first.blockHeight < 0 || !chainActive[item.first.blockHeight])
+                continue;
+            if (pblockindex && std::make_pair(item.first.blockHeight, item.first.txindex) >= std::make_pair(entry.first.blockHeight, entry.first.txindex))
+                continue;
+            pblockindex = chainActive[item.first.blockHeight];
+            entry = item;
+        }
+        if (!pblockindex)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+        if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
+
+        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        nConfirmations = chainActive.Height() - pblockindex->nHeight + 1;
+    }
+
+    // the index entry points at the transaction and output, no need to parse the other ones
+    CTransactionRef tx;
+    if (entry.first.txindex < block.vtx.size() && block.vtx[entry.first.txindex]->GetHash() == entry.second.txhash)
+        tx = block.vtx[entry.first.txindex];
+    uint32_t nOut = entry.second.vout;
+    if (!tx)
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    // header and Merkle branch as in a filtered block, so a client only needs the header chain
+    CMerkleBlock merkleBlock(block, std::set<uint256>{tx->GetHash()});
+    CDataStream ssProof(SER_NETWORK, PROTOCOL_VERSION);
+    ssProof << merkleBlock << (int32_t)pblockindex->nHeight << nOut << tx;
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryProof = ssProof.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryProof);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssProof.begin(), ssProof.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        CDataStream ssMerkleBlock(SER_NETWORK, PROTOCOL_VERSION);
+        ssMerkleBlock << merkleBlock;
+        CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+        ssTx << tx;
+
+        UniValue objProof(UniValue::VOBJ);
+        objProof.push_back(Pair("txid", tx->GetHash().GetHex()));
+        objProof.push_back(Pair("vout", (int)nOut));
+        objProof.push_back(Pair("height", pblockindex->nHeight));
+        objProof.push_back(Pair("blockhash", pblockindex->GetBlockHash().GetHex()));
+        objProof.push_back(Pair("confirmations", nConfirmations));
+        objProof.push_back(Pair("merkleproof", HexStr(ssMerkleBlock.begin(), ssMerkleBlock.end())));
+        objProof.push_back(Pair("hex", HexStr(ssTx.begin(), ssTx.end())));
+        std::string strJSON = objProof.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_docfilters(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (!fDocFilterIndex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Document filter index not enabled (-docfilterindex)");
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No filter count specified. Use /rest/docfilters/<count>/<hash>.<ext>.");
+
+    long count = strtol(path[0].c_str(), NULL, 10);
+    if (count < 1 || count > (long)MAX_GETDOCFILTERS_SIZE)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Filter count out of range: " + path[0]);
+
+    std::string hashStr = path[1];
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    std::vector<std::pair<const CBlockIndex*, std::pair<CDocumentFilter, uint256> > > filters;
+    filters.reserve(count);
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(hash);
+        const CBlockIndex *pindex = (it != mapBlockIndex.end()) ? it->second : NULL;
+        while (pindex != NULL && chainActive.Contains(pindex)) {
+            CDocumentFilter filter;
+            uint256 header;
+            if (!GetDocumentFilter(pindex, filter, header))
+                return RESTERR(req, HTTP_NOT_FOUND, "No document filter for block " + pindex->GetBlockHash().GetHex());
+            filters.push_back(std::make_pair(pindex, std::make_pair(filter, header)));
+            if (filters.size() == (unsigned long)count)
+                break;
+            pindex = chainActive.Next(pindex);
+        }
+    }
+
+    // per block: the block hash, the encoded filter and the filter header
+    CDataStream ssFilters(SER_NETWORK, PROTOCOL_VERSION);
+    for (const auto& item : filters)
+        ssFilters << item.first->GetBlockHash() << item.second.first.GetEncoded() << item.second.second;
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryFilters = ssFilters.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryFilters);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssFilters.begin(), ssFilters.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+    case RF_JSON: {
+        UniValue jsonFilters(UniValue::VARR);
+        for (const auto& item : filters) {
+            UniValue entry(UniValue::VOBJ);
+            entry.push_back(Pair("blockhash", item.first->GetBlockHash().GetHex()));
+            entry.push_back(Pair("height", item.first->nHeight));
+            entry.push_back(Pair("n", (uint64_t)item.second.first.GetN()));
+            entry.push_back(Pair("filter", HexStr(item.second.first.GetEncoded())));
+            entry.push_back(Pair("header", item.second.second.GetHex()));
+            jsonFilters.push_back(entry);
+        }
+        std::string strJSON = jsonFilters.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -591,6 +802,34 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_metrics(HTTPRequest* req, const std::string& strURIPart)
+{
+    // Prometheus text exposition format, times in seconds as is the convention there
+    std::map<std::string, CNetCommandStats> mapStats = netStats.GetCommandStats();
+    std::string strMetrics;
+    strMetrics += "# HELP dms_p2p_message_bytes_total Payload bytes of processed P2P messages.\n";
+    strMetrics += "# TYPE dms_p2p_message_bytes_total counter\n";
+    for (const auto& entry : mapStats)
+        strMetrics += strprintf("dms_p2p_message_bytes_total{command=\"%s\"} %u\n", entry.first, entry.second.nBytes);
+    strMetrics += "# HELP dms_p2p_process_seconds Time spent processing P2P messages.\n";
+    strMetrics += "# TYPE dms_p2p_process_seconds summary\n";
+    for (const auto& entry : mapStats) {
+        const CTimeHistogram& time = entry.second.timeProcess;
+        for (double dQuantile : {0.5, 0.9, 0.99})
+            strMetrics += strprintf("dms_p2p_process_seconds{command=\"%s\",quantile=\"%g\"} %.6f\n", entry.first, dQuantile, time.GetPercentile(dQuantile * 100) * 1e-6);
+        strMetrics += strprintf("dms_p2p_process_seconds_sum{command=\"%s\"} %.6f\n", entry.first, time.GetTotal() * 1e-6);
+        strMetrics += strprintf("dms_p2p_process_seconds_count{command=\"%s\"} %u\n", entry.first, time.GetCount());
+    }
+    strMetrics += "# HELP dms_p2p_csmain_wait_seconds_total Time spent waiting for cs_main while processing P2P messages.\n";
+    strMetrics += "# TYPE dms_p2p_csmain_wait_seconds_total counter\n";
+    for (const auto& entry : mapStats)
+        strMetrics += strprintf("dms_p2p_csmain_wait_seconds_total{command=\"%s\"} %.6f\n", entry.first, entry.second.nLockWait * 1e-6);
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, strMetrics);
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -603,6 +842,9 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/document/", rest_document},
+      {"/rest/docfilters/", rest_docfilters},
+      {"/rest/metrics", rest_metrics},
 };
 
 bool StartREST()
@@ -54,6 +54,15 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getreceivedbyaccount", 2, "addlockconf" },
     { "listaddressbalances", 0, "minamount" },
     { "listdocuments", 1, "verbose" },
+    { "verifydocumentproof", 0, "proof" },
+    { "verifydocuments", 0, "documents" },
+    { "storedocuments", 0, "payloads" },
+    { "hashdocuments", 0, "files" },
+    { "hashdocuments", 1, "algos" },
+    { "hashdocuments", 2, "threads" },
+    { "listdocuments", 2, "limit" },
+    { "listdocuments", 4, "fromheight" },
+    { "listdocuments", 5, "toheight" },
     { "listreceivedbyaddress", 0, "minconf" },
     { "listreceivedbyaddress", 1, "addlockconf" },
     { "listreceivedbyaddress", 2, "include_empty" },
@@ -145,6 +154,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setban", 3, "absolute" },
     { "setbip69enabled", 0, "enabled" },
     { "setnetworkactive", 0, "state" },
+    { "getnetstats", 0, "reset" },
+    { "getlockstats", 0, "reset" },
     { "setprivatesendrounds", 0, "rounds" },
     { "setprivatesendamount", 0, "amount" },
     { "getmempoolancestors", 1, "verbose" },
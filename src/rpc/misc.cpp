@@ -7,6 +7,9 @@
 
 #include "base58.h"
 #include "clientversion.h"
+#include "documentbatch.h"
+#include "documenthash.h"
+#include "documentindexer.h"
 #include "init.h"
 #include "net.h"
 #include "netbase.h"
@@ -1050,16 +1053,41 @@ UniValue getdocumentcount(const JSONRPCRequest& request)
     return totalCount;
 }
 
+// Whether the hex string is a hash of any supported document hash algorithm
+static bool IsDocumentHashHex(const std::string& strHash)
+{
+    if (!IsHex(strHash))
+        return false;
+    for (int algo = 0; algo < 40; algo++) {
+        if (CDocument::HashHexLength(algo) == (int)strHash.length())
+            return true;
+    }
+    return false;
+}
+
+/** Index entries listdocuments looks at per call when filtering by height, the index is ordered by hash */
+static const int MAX_LISTDOCUMENTS_SCAN = 100000;
+
 UniValue listdocuments(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() > 2)
+    if (request.fHelp || request.params.size() > 6)
         throw std::runtime_error(
-            "listdocuments ( \"filehash\" verbose )\n"
+            "listdocuments ( \"filehash\" verbose limit \"cursor\" fromheight toheight )\n"
             "\nList documents archived (requires documentindex to be enabled).\n"
-            "If 'filehash' is specified, only documents with this hash are listed.\n"
+            "If 'filehash' is specified, only documents with this hash are listed, in any supported algorithm of its length.\n"
+            "Each document is listed by its MD5 index hash, or by its file hash if it has none.\n"
+            "If 'limit', 'cursor' or a height range is specified, the documents are returned in pages, see below.\n"
+            "The index is ordered by hash, so a height range filters the entries while scanning them: each call scans\n"
+            "at most " + std::to_string(MAX_LISTDOCUMENTS_SCAN) + " entries and returns a cursor to continue, even if the page has less documents.\n"
+            "Unconfirmed documents from the mempool follow the confirmed ones with height -1, unless 'toheight' is set.\n"
+            "They count against 'limit' and are paged by their position, which changes with the mempool.\n"
             "\nArguments:\n"
-            "1. \"filehash\"             (string, optional) The file hash used as filter.\n"
+            "1. \"filehash\"             (string, optional) The file hash used as filter, \"\" for all documents.\n"
             "2. verbose                (boolean, optional, default=false) true for a json object, false for an array.\n"
+            "3. limit                  (numeric, optional, default=0) The maximum number of documents to return, 0 for no limit.\n"
+            "4. \"cursor\"               (string, optional) The cursor returned by the previous call to continue listing.\n"
+            "5. fromheight             (numeric, optional, default=0) Only list documents at or above this block height.\n"
+            "6. toheight               (numeric, optional, default=0) Only list documents at or below this block height, 0 for no limit.\n"
             "\nResult (for verbose=false, suitable for simple listings)\n"
             "{\n"
             "  \"filehash\": \"tx\",       (string) The file hash and the transaction id\n"
@@ -1069,19 +1097,29 @@ UniValue listdocuments(const JSONRPCRequest& request)
             "[                         (array of json object)\n"
             "  {\n"
             "    \"hash\" : \"hash\",      (string) the file hash \n"
-            "    \"txid\" : \"txid\"       (string) the transaction id \n"
+            "    \"algo\" : \"MD5\",       (string) the hash algorithm\n"
+            "    \"txid\" : \"txid\",      (string) the transaction id \n"
+            "    \"height\" : n,         (numeric) the block height, -1 if unconfirmed\n"
+            "    \"vout\" : n            (numeric) the output of the document, missing if unconfirmed\n"
             "  }\n"
             "  ,...\n"
             "]\n"
+            "\nResult (if limit, cursor or a height range is specified)\n"
+            "{\n"
+            "  \"documents\" : ...,      (json object or array) one page of documents as above\n"
+            "  \"cursor\" : \"cursor\"     (string, optional) pass to the next call to continue, missing on the last page\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("listdocuments", "")
+            + HelpExampleCli("listdocuments", "\"\" true 1000")
+            + HelpExampleCli("listdocuments", "\"\" true 1000 \"cursor\" 100000 200000")
             + HelpExampleRpc("listdocuments", "")
         );
 
     std::string strHashfilter;
     if (request.params.size() > 0) {
         strHashfilter = request.params[0].get_str();
-        if (!strHashfilter.empty() && (strHashfilter.length() != 32))
+        if (!strHashfilter.empty() && !IsDocumentHashHex(strHashfilter))
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strHashfilter + " is not a file hash");
     }
 
@@ -1089,26 +1127,806 @@ UniValue listdocuments(const JSONRPCRequest& request)
     if (request.params.size() > 1)
         fVerbose = request.params[1].get_bool();
 
-    std::vector<std::pair<CDocumentIndexKey, std::string> > documentList;
-    if (!GetDocumentList(documentList, strHashfilter))
-        throw JSONRPCError(RPC_MISC_ERROR, "Document index not enabled");
+    int nLimit = 0;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        nLimit = request.params[2].get_int();
+        if (nLimit < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative limit");
+    }
 
-    if (!fVerbose) {
-        UniValue result(UniValue::VOBJ);
-        for (std::vector<std::pair<CDocumentIndexKey, std::string> >::iterator it = documentList.begin(); it != documentList.end(); it++)
-            result.push_back(Pair(it->first.fileHash(), it->second));
-        return result;
+    bool fPaged = nLimit > 0;
+    // a cursor at height -1 continues with the unconfirmed documents, txindex is the position among them
+    CDocumentIndexKey cursorKey;
+    bool fHasCursor = false;
+    if (request.params.size() > 3 && !request.params[3].isNull() && !request.params[3].get_str().empty()) {
+        std::string strCursor = request.params[3].get_str();
+        if (!IsHex(strCursor))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        CDataStream ssCursor(ParseHex(strCursor), SER_DISK, CLIENT_VERSION);
+        try {
+            ssCursor >> cursorKey;
+        } catch (const std::exception&) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        fHasCursor = true;
+        fPaged = true;
     }
-    else {
-        UniValue results(UniValue::VARR);
-        for (std::vector<std::pair<CDocumentIndexKey, std::string> >::iterator it = documentList.begin(); it != documentList.end(); it++) {
+
+    int nFromHeight = 0;
+    if (request.params.size() > 4 && !request.params[4].isNull())
+        nFromHeight = request.params[4].get_int();
+
+    int nToHeight = 0;
+    if (request.params.size() > 5 && !request.params[5].isNull())
+        nToHeight = request.params[5].get_int();
+
+    if (nFromHeight < 0 || nToHeight < 0 || (nToHeight > 0 && nToHeight < nFromHeight))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+
+    bool fHeightRange = nFromHeight > 0 || nToHeight > 0;
+    fPaged |= fHeightRange;
+    bool fMempoolCursor = fHasCursor && cursorKey.blockHeight == -1;
+
+    // entries are streamed from the database cursor, at most one page is held in memory
+    UniValue documents(fVerbose ? UniValue::VARR : UniValue::VOBJ);
+    int nCount = 0;
+    int nScanned = 0;
+    bool fMore = false;
+    CDocumentIndexKey lastKey;
+    auto visitor = [&](const CDocumentIndexKey& key, const CDocumentIndexValue& value) {
+        if (fHeightRange && nScanned++ >= MAX_LISTDOCUMENTS_SCAN) {
+            fMore = true;
+            return false;
+        }
+        if (key.blockHeight < nFromHeight || (nToHeight > 0 && key.blockHeight > nToHeight)) {
+            lastKey = key;
+            return true;
+        }
+        if (nLimit > 0 && nCount >= nLimit) {
+            fMore = true;
+            return false;
+        }
+        if (fVerbose) {
             UniValue entry(UniValue::VOBJ);
-            entry.push_back(Pair("hash", it->first.fileHash()));
-            entry.push_back(Pair("txid", it->second));
+            entry.push_back(Pair("hash", key.fileHash()));
+            entry.push_back(Pair("algo", CDocumentHash(key.algo, "").AlgoName()));
+            entry.push_back(Pair("txid", value.txhash.GetHex()));
+            entry.push_back(Pair("height", key.blockHeight));
+            entry.push_back(Pair("vout", (int)key.vout));
+            documents.push_back(entry);
+        }
+        else {
+            documents.push_back(Pair(key.fileHash(), value.txhash.GetHex()));
+        }
+        lastKey = key;
+        nCount++;
+        return true;
+    };
+
+    if (fMempoolCursor) {
+        if (!fDocumentIndex)
+            throw JSONRPCError(RPC_MISC_ERROR, "Document index not enabled");
+    } else if (!GetDocumentList(visitor, strHashfilter, fHasCursor ? &cursorKey : nullptr)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Document index not enabled");
+    }
+
+    // unconfirmed documents follow the confirmed ones
+    if (!fMore && nToHeight == 0) {
+        // the mempool indexes MD5 and full-width hashes alike, without a filter
+        // a transaction seen with its MD5 hash is not listed again
+        std::vector<std::pair<CMempoolDocumentKey, int64_t> > mempoolDocuments;
+        std::vector<CMempoolDocumentKey> vUnconfirmed;
+        std::set<uint256> setListed;
+        std::vector<unsigned char> vchFilter = ParseHex(strHashfilter);
+        for (int algo = 0; algo < 40; algo++) {
+            if (CDocument::HashHexLength(algo) > 0 && (strHashfilter.empty() || CDocument::HashHexLength(algo) == (int)strHashfilter.length()))
+                mempool.getDocumentIndex(DOCUMENT_HASH_FILE, algo, vchFilter, mempoolDocuments);
+        }
+        for (const auto& item : mempoolDocuments) {
+            if (strHashfilter.empty() && !setListed.insert(item.first.txhash).second && item.first.algo != 0)
+                continue;
+            vUnconfirmed.push_back(item.first);
+        }
+        for (size_t i = fMempoolCursor ? cursorKey.txindex : 0; i < vUnconfirmed.size(); i++) {
+            if (nLimit > 0 && nCount >= nLimit) {
+                fMore = true;
+                lastKey = CDocumentIndexKey(0, std::vector<unsigned char>(CDocument::HashHexLength(0) / 2), -1, i, 0);
+                break;
+            }
+            const CMempoolDocumentKey& item = vUnconfirmed[i];
+            std::string strHash = HexStr(item.hash);
+            if (fVerbose) {
+                UniValue entry(UniValue::VOBJ);
+                entry.push_back(Pair("hash", strHash));
+                entry.push_back(Pair("algo", CDocumentHash(item.algo, "").AlgoName()));
+                entry.push_back(Pair("txid", item.txhash.GetHex()));
+                entry.push_back(Pair("height", -1));
+                documents.push_back(entry);
+            }
+            else {
+                documents.push_back(Pair(strHash, item.txhash.GetHex()));
+            }
+            nCount++;
+        }
+    }
+
+    if (!fPaged)
+        return documents;
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("documents", documents));
+    if (fMore) {
+        CDataStream ssCursor(SER_DISK, CLIENT_VERSION);
+        ssCursor << lastKey;
+        result.push_back(Pair("cursor", HexStr(ssCursor.begin(), ssCursor.end())));
+    }
+    return result;
+}
+
+// Algorithm id from its name, or the lowest id matching the hash length (SHA2 before SHA3)
+static int ParseDocumentHashAlgo(const std::string& strHash, const UniValue& algoParam)
+{
+    std::string strAlgo;
+    if (!algoParam.isNull()) {
+        strAlgo = algoParam.get_str();
+        std::transform(strAlgo.begin(), strAlgo.end(), strAlgo.begin(), ::toupper);
+    }
+    for (int algo = 0; algo < 40; algo++) {
+        if (CDocument::HashHexLength(algo) != (int)strHash.length())
+            continue;
+        if (strAlgo.empty() || CDocumentHash(algo, "").AlgoName() == strAlgo)
+            return algo;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, "No " + (strAlgo.empty() ? std::string("supported") : strAlgo) + " hash algorithm matches the hash length");
+}
+
+static void DocumentHashIndexToJSON(unsigned char type, int algo, const std::string& strHash, UniValue& results)
+{
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentList;
+    if (!GetDocumentsByHash(type, algo, strHash, documentList))
+        throw JSONRPCError(RPC_MISC_ERROR, "Document index not enabled");
+
+    for (std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >::iterator it = documentList.begin(); it != documentList.end(); it++) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("hash", it->first.hashHex()));
+        entry.push_back(Pair("algo", CDocumentHash(it->first.algo, "").AlgoName()));
+        entry.push_back(Pair("txid", it->second.txhash.GetHex()));
+        entry.push_back(Pair("vout", (int)it->second.vout));
+        entry.push_back(Pair("height", it->first.blockHeight));
+        entry.push_back(Pair("blockindex", (int)it->first.txindex));
+        results.push_back(entry);
+    }
+}
+
+UniValue getdocumentbyguid(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getdocumentbyguid \"guid\"\n"
+            "\nReturns the documents archived with the given GUID (requires documentindex to be enabled).\n"
+            "\nArguments:\n"
+            "1. \"guid\"                 (string, required) The document GUID, with or without braces and dashes\n"
+            "\nResult:\n"
+            "[                         (array of json object)\n"
+            "  {\n"
+            "    \"hash\" : \"hash\",      (string) the compressed GUID\n"
+            "    \"algo\" : \"MD5\",       (string) always MD5 for GUIDs\n"
+            "    \"txid\" : \"txid\",      (string) the transaction id\n"
+            "    \"vout\" : n,           (numeric) the output holding the document\n"
+            "    \"height\" : n,         (numeric) the block height, -1 if unconfirmed\n"
+            "    \"blockindex\" : n      (numeric) the position of the transaction in the block\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdocumentbyguid", "\"{8c25cfe6-1d4b-4f5e-9a0b-3c4a41d2c6f1}\"")
+            + HelpExampleRpc("getdocumentbyguid", "\"8c25cfe61d4b4f5e9a0b3c4a41d2c6f1\"")
+        );
+
+    std::string strGuid;
+    for (char c : request.params[0].get_str()) {
+        if (c != '{' && c != '}' && c != '-')
+            strGuid += c;
+    }
+    if (strGuid.length() != 32 || !IsHex(strGuid))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, request.params[0].get_str() + " is not a GUID");
+
+    UniValue results(UniValue::VARR);
+    DocumentHashIndexToJSON(DOCUMENT_HASH_GUID, 0, strGuid, results);
+    return results;
+}
+
+UniValue finddocuments(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "finddocuments \"hash\" ( \"hashtype\" \"algo\" )\n"
+            "\nFind documents archived by one of their hashes (requires documentindex to be enabled).\n"
+            "Unlike listdocuments, this is a point lookup and accepts full-width SHA-2/SHA-3 hashes.\n"
+            "\nArguments:\n"
+            "1. \"hash\"                 (string, required) The hash in hex\n"
+            "2. \"hashtype\"             (string, optional, default=\"file\") One of \"file\", \"owner\", \"guid\" or \"batch\" (Merkle root)\n"
+            "3. \"algo\"                 (string, optional) The hash algorithm, e.g. \"SHA2-256\" or \"SHA3-256\".\n"
+            "                          If omitted, all algorithms matching the hash length are searched.\n"
+            "\nResult:\n"
+            "[                         (array of json object)\n"
+            "  {\n"
+            "    \"hash\" : \"hash\",      (string) the hash\n"
+            "    \"algo\" : \"algo\",      (string) the hash algorithm\n"
+            "    \"txid\" : \"txid\",      (string) the transaction id\n"
+            "    \"vout\" : n,           (numeric) the output holding the document\n"
+            "    \"height\" : n,         (numeric) the block height, -1 if unconfirmed\n"
+            "    \"blockindex\" : n      (numeric) the position of the transaction in the block\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("finddocuments", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\"")
+            + HelpExampleCli("finddocuments", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\" \"owner\" \"SHA3-256\"")
+            + HelpExampleRpc("finddocuments", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\", \"file\"")
+        );
+
+    std::string strHash = request.params[0].get_str();
+    if (!IsHex(strHash))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strHash + " is not a hex hash");
+
+    unsigned char type = DOCUMENT_HASH_FILE;
+    if (request.params.size() > 1 && !request.params[1].isNull()) {
+        std::string strType = request.params[1].get_str();
+        if (strType == "file")
+            type = DOCUMENT_HASH_FILE;
+        else if (strType == "owner")
+            type = DOCUMENT_HASH_OWNER;
+        else if (strType == "guid")
+            type = DOCUMENT_HASH_GUID;
+        else if (strType == "batch")
+            type = DOCUMENT_HASH_BATCH;
+        else
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid hashtype: " + strType);
+    }
+
+    std::string strAlgo;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        strAlgo = request.params[2].get_str();
+        std::transform(strAlgo.begin(), strAlgo.end(), strAlgo.begin(), ::toupper);
+    }
+
+    // algorithm ids are below 40, several algorithms may share a hash length
+    UniValue results(UniValue::VARR);
+    bool fAlgoFound = false;
+    for (int algo = 0; algo < 40; algo++) {
+        if (CDocument::HashHexLength(algo) != (int)strHash.length())
+            continue;
+        if (type == DOCUMENT_HASH_GUID && algo != 0)
+            continue;
+        if (type == DOCUMENT_HASH_BATCH && algo != 22)
+            continue;
+        if (!strAlgo.empty() && CDocumentHash(algo, "").AlgoName() != strAlgo)
+            continue;
+        fAlgoFound = true;
+        DocumentHashIndexToJSON(type, algo, strHash, results);
+    }
+
+    if (!fAlgoFound)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No " + (strAlgo.empty() ? std::string("supported") : strAlgo) + " hash algorithm matches the hash length");
+
+    return results;
+}
+
+/** Maximum number of documents verified in one verifydocuments call */
+static const unsigned int MAX_VERIFYDOCUMENTS = 50000;
+
+// Hashes given for one item of verifydocuments, the first one is looked up, the others must match its transaction
+struct DocumentVerifyItem
+{
+    std::vector<size_t> vKeys;
+    std::string strError;
+};
+
+static size_t AddDocumentVerifyKey(std::vector<CDocumentHashIndexIteratorKey>& keys, unsigned char type, int algo, const std::string& strHash)
+{
+    keys.push_back(CDocumentHashIndexIteratorKey(type, algo, ParseHex(strHash)));
+    return keys.size() - 1;
+}
+
+UniValue verifydocuments(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1 || !request.params[0].isArray())
+        throw std::runtime_error(
+            "verifydocuments [{\"indexhash\":\"hash\",\"filehash\":\"hash\",\"algo\":\"algo\",\"guid\":\"guid\"},...]\n"
+            "\nVerify many documents in one call (requires documentindex to be enabled).\n"
+            "All hashes are resolved in one sorted pass over the document index.\n"
+            "An item is valid if a single transaction contains all of its hashes.\n"
+            "\nArguments:\n"
+            "1. documents              (array, required) at most " + std::to_string(MAX_VERIFYDOCUMENTS) + " items, each a json object\n"
+            "                          or a string with the MD5 index hash\n"
+            "    [\n"
+            "      {\n"
+            "        \"indexhash\":\"hash\", (string, optional) the MD5 index hash\n"
+            "        \"filehash\":\"hash\",  (string, optional) the full-width file hash\n"
+            "        \"algo\":\"algo\",      (string, optional) the algorithm of filehash, default by hash length\n"
+            "        \"guid\":\"guid\"       (string, optional) the document GUID\n"
+            "      }\n"
+            "      ,...\n"
+            "    ]\n"
+            "\nResult:\n"
+            "[                         (array of json object) in the order of the request\n"
+            "  {\n"
+            "    \"status\" : \"status\",  (string) \"confirmed\", \"unconfirmed\", \"mismatch\" (the hashes belong to\n"
+            "                          different documents), \"notfound\" or \"invalid\"\n"
+            "    \"error\" : \"text\",     (string, if invalid) why the item was rejected\n"
+            "    \"txid\" : \"txid\",      (string) the first transaction containing all hashes\n"
+            "    \"vout\" : n,           (numeric) the output of that document\n"
+            "    \"height\" : n,         (numeric) the block height, -1 if unconfirmed\n"
+            "    \"blocktime\" : n,      (numeric) the block time in seconds since epoch\n"
+            "    \"confirmations\" : n,  (numeric) the number of confirmations\n"
+            "    \"count\" : n           (numeric) the number of transactions containing all hashes\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("verifydocuments", "'[\"0f343b0931126a20f133d67c2b018a3b\",{\"indexhash\":\"0f343b0931126a20f133d67c2b018a3b\",\"guid\":\"8c25cfe61d4b4f5e9a0b3c4a41d2c6f1\"}]'")
+            + HelpExampleRpc("verifydocuments", "[{\"filehash\":\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\",\"algo\":\"SHA2-256\"}]")
+        );
+
+    const std::vector<UniValue>& vRequest = request.params[0].getValues();
+    if (vRequest.size() > MAX_VERIFYDOCUMENTS)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("At most %u documents per call", MAX_VERIFYDOCUMENTS));
+
+    std::vector<DocumentVerifyItem> vItems(vRequest.size());
+    std::vector<CDocumentHashIndexIteratorKey> keys;
+    for (size_t i = 0; i < vRequest.size(); i++) {
+        const UniValue& item = vRequest[i];
+        std::string strIndexHash, strFileHash, strGuid;
+        UniValue algo;
+        if (item.isStr()) {
+            strIndexHash = item.get_str();
+        } else if (item.isObject()) {
+            if (find_value(item, "indexhash").isStr())
+                strIndexHash = find_value(item, "indexhash").get_str();
+            if (find_value(item, "filehash").isStr())
+                strFileHash = find_value(item, "filehash").get_str();
+            if (find_value(item, "guid").isStr()) {
+                for (char c : find_value(item, "guid").get_str()) {
+                    if (c != '{' && c != '}' && c != '-')
+                        strGuid += c;
+                }
+            }
+            algo = find_value(item, "algo");
+        }
+
+        DocumentVerifyItem& verify = vItems[i];
+        try {
+            if (strIndexHash.empty() && strFileHash.empty() && strGuid.empty())
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "No hash given");
+            if (!strIndexHash.empty() && (strIndexHash.length() != 32 || !IsHex(strIndexHash)))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strIndexHash + " is not an MD5 index hash");
+            if (!strGuid.empty() && (strGuid.length() != 32 || !IsHex(strGuid)))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strGuid + " is not a GUID");
+            if (!strFileHash.empty() && !IsHex(strFileHash))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strFileHash + " is not a hex hash");
+            int nFileAlgo = strFileHash.empty() ? 0 : ParseDocumentHashAlgo(strFileHash, algo);
+
+            if (!strIndexHash.empty())
+                verify.vKeys.push_back(AddDocumentVerifyKey(keys, DOCUMENT_HASH_FILE, 0, strIndexHash));
+            if (!strFileHash.empty())
+                verify.vKeys.push_back(AddDocumentVerifyKey(keys, DOCUMENT_HASH_FILE, nFileAlgo, strFileHash));
+            if (!strGuid.empty())
+                verify.vKeys.push_back(AddDocumentVerifyKey(keys, DOCUMENT_HASH_GUID, 0, strGuid));
+        } catch (const UniValue& objError) {
+            verify.strError = find_value(objError, "message").get_str();
+        }
+    }
+
+    // the index is written under cs_main when blocks connect, so reading it under the same lock
+    // as the chain keeps a reorg from leaving entries of blocks that are no longer active
+    LOCK(cs_main);
+    std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > > documentLists;
+    if (!GetDocumentsByHashes(keys, documentLists))
+        throw JSONRPCError(RPC_MISC_ERROR, "Document index not enabled");
+
+    UniValue results(UniValue::VARR);
+    for (const DocumentVerifyItem& verify : vItems) {
+        UniValue entry(UniValue::VOBJ);
+        if (!verify.strError.empty()) {
+            entry.push_back(Pair("status", "invalid"));
+            entry.push_back(Pair("error", verify.strError));
             results.push_back(entry);
+            continue;
+        }
+
+        // candidates are the transactions of the first hash, in height order with unconfirmed ones last
+        const std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& candidates = documentLists[verify.vKeys[0]];
+        const std::pair<CDocumentHashIndexKey, CDocumentIndexValue>* pFirst = nullptr;
+        int nCount = 0;
+        for (const auto& candidate : candidates) {
+            bool fMatch = true;
+            for (size_t k = 1; k < verify.vKeys.size() && fMatch; k++) {
+                const auto& other = documentLists[verify.vKeys[k]];
+                fMatch = std::any_of(other.begin(), other.end(), [&candidate](const std::pair<CDocumentHashIndexKey, CDocumentIndexValue>& item) {
+                    return item.second == candidate.second;
+                });
+            }
+            if (!fMatch)
+                continue;
+            if (!pFirst)
+                pFirst = &candidate;
+            nCount++;
+        }
+
+        if (!pFirst) {
+            entry.push_back(Pair("status", candidates.empty() ? "notfound" : "mismatch"));
+            results.push_back(entry);
+            continue;
+        }
+
+        int nHeight = pFirst->first.blockHeight;
+        CBlockIndex* pindex = nHeight >= 0 ? chainActive[nHeight] : nullptr;
+        entry.push_back(Pair("status", pindex ? "confirmed" : "unconfirmed"));
+        entry.push_back(Pair("txid", pFirst->second.txhash.GetHex()));
+        entry.push_back(Pair("vout", (int)pFirst->second.vout));
+        entry.push_back(Pair("height", pindex ? nHeight : -1));
+        if (pindex)
+            entry.push_back(Pair("blocktime", pindex->GetBlockTime()));
+        entry.push_back(Pair("confirmations", pindex ? chainActive.Height() - nHeight + 1 : 0));
+        entry.push_back(Pair("count", nCount));
+        results.push_back(entry);
+    }
+    return results;
+}
+
+/** Maximum number of files hashed in one hashdocuments call */
+static const unsigned int MAX_HASHDOCUMENTS = 10000;
+
+UniValue hashdocuments(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "hashdocuments [\"file\",...] ( [\"algo\",...] threads )\n"
+            "\nHash files on the node for document registration.\n"
+            "Every file is read once for all algorithms, files are hashed in parallel.\n"
+            "\nArguments:\n"
+            "1. files       (array, required) at most " + std::to_string(MAX_HASHDOCUMENTS) + " file names with full path\n"
+            "2. algos       (array, optional, default=[\"MD5\",\"SHA3-512\"]) the hash algorithms, MD5 is the index hash\n"
+            "3. threads     (numeric, optional, default=0) the number of hashing threads, 0 = one per core, at most the number of cores\n"
+            "\nResult:\n"
+            "[                     (array of json object) in the order of the files\n"
+            "  {\n"
+            "    \"file\" : \"name\",    (string) the file name\n"
+            "    \"size\" : n,         (numeric) the file size in bytes\n"
+            "    \"hashes\" : {        (json object) the uppercase hex hash of every algorithm\n"
+            "      \"algo\" : \"hash\"\n"
+            "      ,...\n"
+            "    },\n"
+            "    \"error\" : \"text\"    (string, instead of size and hashes) why the file could not be hashed\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("hashdocuments", "'[\"/home/archive/invoice.pdf\"]' '[\"MD5\",\"SHA2-256\"]'")
+            + HelpExampleRpc("hashdocuments", "[\"/home/archive/invoice.pdf\"], [\"MD5\",\"SHA2-256\"]")
+        );
+
+    const UniValue& files = request.params[0].get_array();
+    if (files.size() > MAX_HASHDOCUMENTS)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("At most %u files per call", MAX_HASHDOCUMENTS));
+
+    std::vector<int> vAlgos;
+    if (request.params.size() > 1 && !request.params[1].isNull()) {
+        for (const UniValue& algoName : request.params[1].get_array().getValues()) {
+            std::string strAlgo = algoName.get_str();
+            std::transform(strAlgo.begin(), strAlgo.end(), strAlgo.begin(), ::toupper);
+            int algo = 0;
+            while (algo < 40 && (CDocumentHash(algo, "").AlgoName() != strAlgo || !IsDocumentHashAlgoSupported(algo)))
+                algo++;
+            if (algo == 40)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Unsupported hash algorithm " + algoName.get_str());
+            vAlgos.push_back(algo);
         }
-        return results;
+    } else {
+        vAlgos = {0, 35};
+    }
+    if (vAlgos.empty())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No hash algorithm given");
+
+    // every thread reads a file at a time, more threads than cores only add seeks
+    int nThreads = 0;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        nThreads = request.params[2].get_int();
+        if (nThreads < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative number of threads");
+        nThreads = std::min(nThreads, std::max(GetNumCores(), 1));
     }
+
+    std::vector<CDocumentFileHashes> vFiles;
+    vFiles.reserve(files.size());
+    for (const UniValue& file : files.getValues())
+        vFiles.push_back(CDocumentFileHashes(file.get_str()));
+
+    HashDocumentFiles(vFiles, vAlgos, nThreads);
+
+    UniValue results(UniValue::VARR);
+    for (const CDocumentFileHashes& file : vFiles) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("file", file.strPath));
+        if (!file.strError.empty()) {
+            entry.push_back(Pair("error", file.strError));
+        } else {
+            entry.push_back(Pair("size", file.nSize));
+            UniValue hashes(UniValue::VOBJ);
+            for (size_t i = 0; i < vAlgos.size(); i++) {
+                std::string strHash = HexStr(file.vHashes[i]);
+                std::transform(strHash.begin(), strHash.end(), strHash.begin(), ::toupper);
+                hashes.push_back(Pair(CDocumentHash(vAlgos[i], "").AlgoName(), strHash));
+            }
+            entry.push_back(Pair("hashes", hashes));
+        }
+        results.push_back(entry);
+    }
+    return results;
+}
+
+UniValue getindexinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getindexinfo ( \"index_name\" )\n"
+            "\nReturns the status of the optional indexes.\n"
+            "\nArguments:\n"
+            "1. \"index_name\"           (string, optional) Only return the status of this index\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\" : {              (json object) the index name, only enabled indexes are listed\n"
+            "    \"synced\" : true|false,      (boolean) true if the index is complete and follows the tip\n"
+            "    \"best_block_height\" : n,    (numeric) the height of the last indexed block\n"
+            "    \"state\" : \"state\"           (string, documentindex only) \"synced\", \"building\" or \"dropping\"\n"
+            "  }\n"
+            "  ,...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getindexinfo", "")
+            + HelpExampleCli("getindexinfo", "\"documentindex\"")
+            + HelpExampleRpc("getindexinfo", "\"documentindex\"")
+        );
+
+    std::string strName;
+    if (request.params.size() > 0)
+        strName = request.params[0].get_str();
+
+    int nHeight;
+    {
+        LOCK(cs_main);
+        nHeight = chainActive.Height();
+    }
+
+    UniValue result(UniValue::VOBJ);
+    if (fTxIndex && (strName.empty() || strName == "txindex")) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("synced", true));
+        entry.push_back(Pair("best_block_height", nHeight));
+        result.push_back(Pair("txindex", entry));
+    }
+
+    CDocumentIndexerStatus status = GetDocumentIndexerStatus();
+    if ((status.fSynced || status.fBuilding || status.fDropping) && (strName.empty() || strName == "documentindex")) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("synced", status.fSynced));
+        entry.push_back(Pair("best_block_height", status.nBestHeight));
+        entry.push_back(Pair("state", status.fSynced ? "synced" : status.fBuilding ? "building" : "dropping"));
+        result.push_back(Pair("documentindex", entry));
+    }
+
+    return result;
+}
+
+static UniValue AnchoredDocumentBatchToJSON(const uint256& root)
+{
+    UniValue anchors(UniValue::VARR);
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentList;
+    if (GetDocumentsByHash(DOCUMENT_HASH_BATCH, 22, HexStr(root.begin(), root.end()), documentList)) {
+        for (const auto& item : documentList) {
+            UniValue entry(UniValue::VOBJ);
+            entry.push_back(Pair("txid", item.second.txhash.GetHex()));
+            entry.push_back(Pair("height", item.first.blockHeight));
+            anchors.push_back(entry);
+        }
+    }
+    return anchors;
+}
+
+UniValue adddocumenttobatch(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "adddocumenttobatch \"hash\" ( \"algo\" )\n"
+            "\nQueue a file hash for the next document batch (requires -documentbatch).\n"
+            "All queued hashes are anchored with a single transaction by anchordocumentbatch\n"
+            "or every -documentbatchinterval seconds.\n"
+            "\nArguments:\n"
+            "1. \"hash\"                 (string, required) The file hash in hex\n"
+            "2. \"algo\"                 (string, optional) The hash algorithm, e.g. \"SHA2-256\", default by hash length\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"leaf\" : \"hex\",         (string) the Merkle leaf of the hash\n"
+            "  \"index\" : n,            (numeric) the position in the batch\n"
+            "  \"pending\" : n           (numeric) the number of documents waiting for the next anchor\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("adddocumenttobatch", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\"")
+            + HelpExampleRpc("adddocumenttobatch", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\", \"SHA3-256\"")
+        );
+
+    if (!documentBatcher)
+        throw JSONRPCError(RPC_MISC_ERROR, "Document batching not enabled (-documentbatch)");
+
+    std::string strHash = request.params[0].get_str();
+    if (!IsHex(strHash))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strHash + " is not a hex hash");
+    int algo = ParseDocumentHashAlgo(strHash, request.params.size() > 1 ? request.params[1] : NullUniValue);
+
+    uint32_t nIndex;
+    std::string strError;
+    std::vector<unsigned char> hash = ParseHex(strHash);
+    if (!documentBatcher->AddDocument(algo, hash, nIndex, strError))
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+
+    uint256 leaf = DocumentBatchLeaf(algo, hash);
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("leaf", HexStr(leaf.begin(), leaf.end())));
+    result.push_back(Pair("index", (int64_t)nIndex));
+    result.push_back(Pair("pending", (int64_t)documentBatcher->GetPendingCount()));
+    return result;
+}
+
+UniValue anchordocumentbatch(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "anchordocumentbatch\n"
+            "\nSend one transaction with the Merkle root of all queued documents (requires -documentbatch and a wallet).\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\" : \"txid\",        (string) the anchoring transaction\n"
+            "  \"root\" : \"hex\",         (string) the Merkle root\n"
+            "  \"count\" : n             (numeric) the number of documents in the batch\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("anchordocumentbatch", "")
+            + HelpExampleRpc("anchordocumentbatch", "")
+        );
+
+    uint256 txid, root;
+    uint32_t nCount;
+    std::string strError;
+    if (!AnchorDocumentBatch(txid, root, nCount, strError))
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("txid", txid.GetHex()));
+    result.push_back(Pair("root", HexStr(root.begin(), root.end())));
+    result.push_back(Pair("count", (int64_t)nCount));
+    return result;
+}
+
+UniValue getdocumentproof(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "getdocumentproof \"hash\" ( \"algo\" )\n"
+            "\nReturns the inclusion proof of a file hash in its document batch (requires -documentbatch).\n"
+            "\nArguments:\n"
+            "1. \"hash\"                 (string, required) The file hash in hex\n"
+            "2. \"algo\"                 (string, optional) The hash algorithm, default by hash length\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"hash\" : \"hex\",         (string) the file hash\n"
+            "  \"algo\" : \"algo\",        (string) the hash algorithm\n"
+            "  \"leaf\" : \"hex\",         (string) the Merkle leaf\n"
+            "  \"index\" : n,            (numeric) the position in the batch\n"
+            "  \"count\" : n,            (numeric) the number of documents in the batch\n"
+            "  \"branch\" : [\"hex\",...], (array of string) the sibling hashes from the leaf up\n"
+            "  \"root\" : \"hex\",         (string) the Merkle root\n"
+            "  \"valid\" : true|false,   (boolean) the branch leads to the root\n"
+            "  \"txid\" : \"txid\",        (string, optional) the anchoring transaction, missing while pending\n"
+            "  \"anchors\" : [           (array, with -documentindex) confirmed transactions carrying the root\n"
+            "    { \"txid\" : \"txid\", \"height\" : n }\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdocumentproof", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\"")
+            + HelpExampleRpc("getdocumentproof", "\"2b5cb5ce6a1ddbfa8b4a52b42e7e0fb7ae1ad4b9d1b3cbd33c5b02c7f2fbd6a8\"")
+        );
+
+    if (!documentBatcher)
+        throw JSONRPCError(RPC_MISC_ERROR, "Document batching not enabled (-documentbatch)");
+
+    std::string strHash = request.params[0].get_str();
+    if (!IsHex(strHash))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strHash + " is not a hex hash");
+    int algo = ParseDocumentHashAlgo(strHash, request.params.size() > 1 ? request.params[1] : NullUniValue);
+
+    CDocumentBatchProof proof;
+    if (!documentBatcher->GetProof(DocumentBatchLeaf(algo, ParseHex(strHash)), proof))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Document not found in any batch");
+
+    UniValue branch(UniValue::VARR);
+    for (const uint256& node : proof.vBranch)
+        branch.push_back(HexStr(node.begin(), node.end()));
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("hash", HexStr(ParseHex(strHash))));
+    result.push_back(Pair("algo", CDocumentHash(algo, "").AlgoName()));
+    result.push_back(Pair("leaf", HexStr(proof.leaf.begin(), proof.leaf.end())));
+    result.push_back(Pair("index", (int64_t)proof.nIndex));
+    result.push_back(Pair("count", (int64_t)proof.nCount));
+    result.push_back(Pair("branch", branch));
+    result.push_back(Pair("root", HexStr(proof.root.begin(), proof.root.end())));
+    result.push_back(Pair("valid", DocumentBatchRootFromBranch(proof.leaf, proof.vBranch, proof.nIndex, proof.nCount) == proof.root));
+    if (!proof.txid.IsNull()) {
+        result.push_back(Pair("txid", proof.txid.GetHex()));
+        result.push_back(Pair("anchors", AnchoredDocumentBatchToJSON(proof.root)));
+    }
+    return result;
+}
+
+UniValue verifydocumentproof(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1 || !request.params[0].isObject())
+        throw std::runtime_error(
+            "verifydocumentproof {proof}\n"
+            "\nVerifies a document batch inclusion proof, as returned by getdocumentproof on any node.\n"
+            "\nArguments:\n"
+            "1. proof                  (json object, required) with the fields hash, algo, index, count, branch and root\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"valid\" : true|false,   (boolean) the hash is part of the batch with this root\n"
+            "  \"anchors\" : [           (array, with -documentindex) confirmed transactions carrying the root\n"
+            "    { \"txid\" : \"txid\", \"height\" : n }\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("verifydocumentproof", "'{\"hash\":\"2b5c...\",\"algo\":\"SHA2-256\",\"index\":0,\"count\":1,\"branch\":[],\"root\":\"8f1e...\"}'")
+            + HelpExampleRpc("verifydocumentproof", "{\"hash\":\"2b5c...\",\"algo\":\"SHA2-256\",\"index\":0,\"count\":1,\"branch\":[],\"root\":\"8f1e...\"}")
+        );
+
+    const UniValue& proof = request.params[0];
+    RPCTypeCheckObj(proof,
+        {
+            {"hash", UniValueType(UniValue::VSTR)},
+            {"algo", UniValueType(UniValue::VSTR)},
+            {"index", UniValueType(UniValue::VNUM)},
+            {"count", UniValueType(UniValue::VNUM)},
+            {"branch", UniValueType(UniValue::VARR)},
+            {"root", UniValueType(UniValue::VSTR)},
+        }, true);
+
+    std::string strHash = find_value(proof, "hash").get_str();
+    if (!IsHex(strHash))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strHash + " is not a hex hash");
+    int algo = ParseDocumentHashAlgo(strHash, find_value(proof, "algo"));
+
+    int64_t nIndex = find_value(proof, "index").get_int64();
+    int64_t nCount = find_value(proof, "count").get_int64();
+    if (nIndex < 0 || nCount <= 0 || nIndex >= nCount || nCount > MAX_DOCUMENTBATCH_SIZE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid index or count");
+
+    std::vector<uint256> vBranch;
+    for (const UniValue& node : find_value(proof, "branch").getValues()) {
+        if (!IsHex(node.get_str()) || node.get_str().length() != 64)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid branch hash");
+        vBranch.push_back(uint256(ParseHex(node.get_str())));
+    }
+
+    std::string strRoot = find_value(proof, "root").get_str();
+    if (!IsHex(strRoot) || strRoot.length() != 64)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid root");
+    uint256 root(ParseHex(strRoot));
+
+    uint256 leaf = DocumentBatchLeaf(algo, ParseHex(strHash));
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("valid", DocumentBatchRootFromBranch(leaf, vBranch, nIndex, nCount) == root));
+    result.push_back(Pair("anchors", AnchoredDocumentBatchToJSON(root)));
+    return result;
 }
 
 UniValue getspentinfo(const JSONRPCRequest& request)
@@ -1200,6 +2018,91 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     return obj;
 }
 
+static void LockStatsToJSON(const CLockSiteStats& stats, UniValue& obj)
+{
+    obj.push_back(Pair("acquisitions", stats.nAcquisitions));
+    obj.push_back(Pair("contentions", stats.nContentions));
+    obj.push_back(Pair("waittime", stats.nWaitTime));
+    obj.push_back(Pair("maxwait", stats.nMaxWait));
+    obj.push_back(Pair("holdtime", stats.nHoldTime));
+    obj.push_back(Pair("maxhold", stats.nMaxHold));
+}
+
+UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getlockstats ( reset )\n"
+            "\nReturns how often each lock was taken, waited for and held, in total and by call site.\n"
+            "Requires -lockstats. Times are in microseconds, locks are sorted by total wait time.\n"
+            "\nArguments:\n"
+            "1. reset   (boolean, optional, default=false) Clear the statistics after returning them\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"cs_main\",     (string) The lock, as named at its call sites\n"
+            "    \"acquisitions\": n,     (numeric) Number of times the lock was taken\n"
+            "    \"contentions\": n,      (numeric) Number of times another thread held it already\n"
+            "    \"waittime\": n,         (numeric) Total time spent waiting for it\n"
+            "    \"maxwait\": n,          (numeric) Longest wait\n"
+            "    \"holdtime\": n,         (numeric) Total time it was held, nested acquisitions included\n"
+            "    \"maxhold\": n,          (numeric) Longest hold\n"
+            "    \"sites\": [             (array) The same by call site, sorted by wait time\n"
+            "      {\n"
+            "        \"site\": \"validation.cpp:1234\", (string) File and line of the LOCK\n"
+            "        ...\n"
+            "      },\n"
+            "      ...\n"
+            "    ]\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleRpc("getlockstats", "true")
+        );
+
+    if (!fLockStats)
+        throw JSONRPCError(RPC_MISC_ERROR, "Lock profiling is disabled, restart with -lockstats");
+
+    bool fReset = request.params.size() > 0 && request.params[0].get_bool();
+    std::vector<CLockSiteStats> vSites = GetLockStats(fReset);
+
+    std::sort(vSites.begin(), vSites.end(), [](const CLockSiteStats& a, const CLockSiteStats& b) {
+        return a.nWaitTime > b.nWaitTime;
+    });
+    std::map<std::string, std::pair<CLockSiteStats, UniValue> > mapLocks;
+    for (const CLockSiteStats& site : vSites) {
+        auto it = mapLocks.emplace(site.strName, std::make_pair(CLockSiteStats(), UniValue(UniValue::VARR))).first;
+        CLockSiteStats& total = it->second.first;
+        total.nAcquisitions += site.nAcquisitions;
+        total.nContentions += site.nContentions;
+        total.nWaitTime += site.nWaitTime;
+        total.nMaxWait = std::max(total.nMaxWait, site.nMaxWait);
+        total.nHoldTime += site.nHoldTime;
+        total.nMaxHold = std::max(total.nMaxHold, site.nMaxHold);
+
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("site", strprintf("%s:%d", site.strFile, site.nLine)));
+        LockStatsToJSON(site, obj);
+        it->second.second.push_back(obj);
+    }
+
+    std::vector<std::pair<std::string, std::pair<CLockSiteStats, UniValue> > > vLocks(mapLocks.begin(), mapLocks.end());
+    std::sort(vLocks.begin(), vLocks.end(), [](const std::pair<std::string, std::pair<CLockSiteStats, UniValue> >& a, const std::pair<std::string, std::pair<CLockSiteStats, UniValue> >& b) {
+        return a.second.first.nWaitTime > b.second.first.nWaitTime;
+    });
+    UniValue ret(UniValue::VARR);
+    for (const auto& lock : vLocks) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", lock.first));
+        LockStatsToJSON(lock.second.first, obj);
+        obj.push_back(Pair("sites", lock.second.second));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -1219,10 +2122,12 @@ static const CRPCCommand commands[] =
     { "control",            "debug",                  &debug,                  true,  {} },
     { "control",            "getinfo",                &getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,  {} },
+    { "control",            "getlockstats",           &getlockstats,           true,  {"reset"} },
     { "util",               "validateaddress",        &validateaddress,        true,  {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         true,  {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          true,  {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, true,  {"privkey","message"} },
+    { "util",               "hashdocuments",          &hashdocuments,          true,  {"files","algos","threads"} },
     { "blockchain",         "getspentinfo",           &getspentinfo,           false, {"json"} },
 
     /* Address index */
@@ -1238,7 +2143,15 @@ static const CRPCCommand commands[] =
 
     /* Document index */
     { "documentindex",      "getdocumentcount",       &getdocumentcount,       true,  {} },
-    { "documentindex",      "listdocuments",          &listdocuments,          true,  {"filehash","verbose"} },
+    { "documentindex",      "listdocuments",          &listdocuments,          true,  {"filehash","verbose","limit","cursor","fromheight","toheight"} },
+    { "documentindex",      "getdocumentbyguid",      &getdocumentbyguid,      true,  {"guid"} },
+    { "documentindex",      "getindexinfo",           &getindexinfo,           true,  {"index_name"} },
+    { "documentindex",      "finddocuments",          &finddocuments,          true,  {"hash","hashtype","algo"} },
+    { "documentindex",      "verifydocuments",        &verifydocuments,        true,  {"documents"} },
+    { "documentbatch",      "adddocumenttobatch",     &adddocumenttobatch,     true,  {"hash","algo"} },
+    { "documentbatch",      "anchordocumentbatch",    &anchordocumentbatch,    false, {} },
+    { "documentbatch",      "getdocumentproof",       &getdocumentproof,       true,  {"hash","algo"} },
+    { "documentbatch",      "verifydocumentproof",    &verifydocumentproof,    true,  {"proof"} },
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            true,  {"timestamp"}},
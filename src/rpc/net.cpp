@@ -11,6 +11,7 @@
 #include "net.h"
 #include "net_processing.h"
 #include "netbase.h"
+#include "netstats.h"
 #include "policy/policy.h"
 #include "protocol.h"
 #include "sync.h"
@@ -109,6 +110,10 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "    \"bytesrecv_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
+            "    },\n"
+            "    \"timerecv_per_msg\": {\n"
+            "       \"addr\": n,              (numeric) The total microseconds spent processing received messages aggregated by message type\n"
+            "       ...\n"
             "    }\n"
             "  }\n"
             "  ,...\n"
@@ -182,6 +187,13 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.push_back(Pair("bytesrecv_per_msg", recvPerMsgCmd));
 
+        UniValue timePerMsgCmd(UniValue::VOBJ);
+        BOOST_FOREACH(const mapMsgCmdSize::value_type &i, stats.mapRecvTimePerMsgCmd) {
+            if (i.second > 0)
+                timePerMsgCmd.push_back(Pair(i.first, i.second));
+        }
+        obj.push_back(Pair("timerecv_per_msg", timePerMsgCmd));
+
         ret.push_back(obj);
     }
 
@@ -369,6 +381,54 @@ UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+UniValue getnetstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getnetstats ( reset )\n"
+            "\nReturns the time spent processing received P2P messages, by message type.\n"
+            "All times are in microseconds. Percentiles are accurate to 25%.\n"
+            "\nArguments:\n"
+            "1. reset   (boolean, optional, default=false) Clear the statistics after returning them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"inv\": {                (object) Statistics of one message type, received at least once\n"
+            "    \"count\": n,            (numeric) Number of messages processed\n"
+            "    \"bytes\": n,            (numeric) Total payload bytes\n"
+            "    \"totaltime\": n,        (numeric) Total processing time\n"
+            "    \"avgtime\": n,          (numeric) Average processing time\n"
+            "    \"p50time\": n,          (numeric) Median processing time\n"
+            "    \"p99time\": n,          (numeric) 99th percentile of the processing time\n"
+            "    \"maxtime\": n,          (numeric) Longest processing time\n"
+            "    \"csmainwait\": n        (numeric) Part of the total processing time spent waiting for cs_main\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getnetstats", "")
+            + HelpExampleRpc("getnetstats", "true")
+       );
+
+    bool fReset = request.params.size() > 0 && request.params[0].get_bool();
+    std::map<std::string, CNetCommandStats> mapStats = netStats.GetCommandStats(fReset);
+
+    UniValue ret(UniValue::VOBJ);
+    for (const auto& entry : mapStats) {
+        const CTimeHistogram& time = entry.second.timeProcess;
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("count", time.GetCount()));
+        obj.push_back(Pair("bytes", entry.second.nBytes));
+        obj.push_back(Pair("totaltime", time.GetTotal()));
+        obj.push_back(Pair("avgtime", time.GetTotal() / (int64_t)time.GetCount()));
+        obj.push_back(Pair("p50time", time.GetPercentile(50)));
+        obj.push_back(Pair("p99time", time.GetPercentile(99)));
+        obj.push_back(Pair("maxtime", time.GetMax()));
+        obj.push_back(Pair("csmainwait", entry.second.nLockWait));
+        ret.push_back(Pair(entry.first, obj));
+    }
+    return ret;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -611,6 +671,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         true,  {"address"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       true,  {"node"} },
     { "network",            "getnettotals",           &getnettotals,           true,  {} },
+    { "network",            "getnetstats",            &getnetstats,            true,  {"reset"} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         true,  {} },
     { "network",            "setban",                 &setban,                 true,  {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             true,  {} },
@@ -10,6 +10,8 @@
 #include "uint256.h"
 #include "amount.h"
 #include "script/script.h"
+#include "primitives/document.h"
+#include "utilstrencodings.h"
 
 struct CSpentIndexKey {
     uint256 txid;
@@ -370,34 +372,61 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+/** Version of the CDocumentIndexKey encoding, stored as its first byte */
+static const unsigned char DOCUMENT_INDEX_KEY_VERSION = 1;
+
+/** Key of the document index: encoding version, algorithm id, raw hash bytes,
+ *  block height, transaction position and output. The hash width follows from
+ *  the algorithm id, so all keys for one hash share a common prefix and any
+ *  supported algorithm is found with a single seek. */
 struct CDocumentIndexKey {
-private:
-    uint128 hashBytes;
-public:
+    unsigned char algo;
+    std::vector<unsigned char> hash;
     int blockHeight;
     unsigned int txindex;
+    unsigned int vout;
 
     size_t GetSerializeSize() const {
-        return 24;
+        return 2 + hash.size() + 12;
     }
     template<typename Stream>
     void Serialize(Stream& s) const {
-        hashBytes.Serialize(s);
+        ser_writedata8(s, DOCUMENT_INDEX_KEY_VERSION);
+        ser_writedata8(s, algo);
+        s.write((const char*)hash.data(), hash.size());
         ser_writedata32be(s, blockHeight);
         ser_writedata32be(s, txindex);
+        ser_writedata32be(s, vout);
     }
     template<typename Stream>
     void Unserialize(Stream& s) {
-        hashBytes.Unserialize(s);
+        if (ser_readdata8(s) != DOCUMENT_INDEX_KEY_VERSION)
+            throw std::ios_base::failure("unknown document index key version");
+        algo = ser_readdata8(s);
+        int nHexLength = CDocument::HashHexLength(algo);
+        if (nHexLength <= 0)
+            throw std::ios_base::failure("unknown document hash algorithm");
+        hash.resize(nHexLength / 2);
+        s.read((char*)hash.data(), hash.size());
         blockHeight = ser_readdata32be(s);
         txindex = ser_readdata32be(s);
+        vout = ser_readdata32be(s);
+    }
+
+    CDocumentIndexKey(unsigned char a, const std::vector<unsigned char>& h, int height, int blockindex, unsigned int n) {
+        algo = a;
+        hash = h;
+        blockHeight = height;
+        txindex = blockindex;
+        vout = n;
     }
 
-    CDocumentIndexKey(std::string sFileHash, int height, int blockindex) {
-        std::transform(sFileHash.begin(), sFileHash.end(), sFileHash.begin(), ::tolower);
-        hashBytes.SetHex(sFileHash);
+    CDocumentIndexKey(const CDocumentHashRef& fileHash, int height, int blockindex, unsigned int n) {
+        algo = fileHash.algo;
+        hash.assign(fileHash.begin(), fileHash.end());
         blockHeight = height;
         txindex = blockindex;
+        vout = n;
     }
 
     CDocumentIndexKey() {
@@ -405,47 +434,239 @@ public:
     }
 
     void SetNull() {
-        hashBytes.SetNull();
+        algo = 0;
+        hash.clear();
         blockHeight = 0;
         txindex = 0;
+        vout = 0;
     }
 
     std::string fileHash() const {
-        return hashBytes.ToString();
+        return HexStr(hash);
+    }
+
+    friend bool operator==(const CDocumentIndexKey& a, const CDocumentIndexKey& b) {
+        return a.algo == b.algo && a.hash == b.hash && a.blockHeight == b.blockHeight &&
+               a.txindex == b.txindex && a.vout == b.vout;
     }
 };
 
 struct CDocumentIndexIteratorKey {
-private:
+    unsigned char algo;
+    std::vector<unsigned char> hash;
+
+    size_t GetSerializeSize() const {
+        return 2 + hash.size();
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, DOCUMENT_INDEX_KEY_VERSION);
+        ser_writedata8(s, algo);
+        s.write((const char*)hash.data(), hash.size());
+    }
+
+    CDocumentIndexIteratorKey(unsigned char a, const std::vector<unsigned char>& h) {
+        algo = a;
+        hash = h;
+    }
+};
+
+/** Value of both document indexes: the transaction and the output holding the document */
+struct CDocumentIndexValue {
+    uint256 txhash;
+    unsigned int vout;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txhash);
+        READWRITE(vout);
+    }
+
+    CDocumentIndexValue(const uint256& t, unsigned int n) {
+        txhash = t;
+        vout = n;
+    }
+
+    CDocumentIndexValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        txhash.SetNull();
+        vout = 0;
+    }
+
+    friend bool operator==(const CDocumentIndexValue& a, const CDocumentIndexValue& b) {
+        return a.txhash == b.txhash && a.vout == b.vout;
+    }
+};
+
+/** Key of the document index before DOCUMENT_INDEX_KEY_VERSION: the MD5 index hash as
+ *  uint128, block height and transaction position. Only read to drop an old index. */
+struct CLegacyDocumentIndexKey {
     uint128 hashBytes;
-public:
+    int blockHeight;
+    unsigned int txindex;
+
     size_t GetSerializeSize() const {
-        return 16;
+        return 24;
     }
     template<typename Stream>
     void Serialize(Stream& s) const {
         hashBytes.Serialize(s);
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, txindex);
     }
     template<typename Stream>
     void Unserialize(Stream& s) {
         hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+        txindex = ser_readdata32be(s);
+    }
+};
+
+/** Secondary document index types, stored as the first byte of CDocumentHashIndexKey */
+enum DocumentHashType : unsigned char {
+    DOCUMENT_HASH_GUID  = 'g', // compressed GUID (16 bytes, algo 0)
+    DOCUMENT_HASH_FILE  = 'f', // full file hash in any supported algorithm
+    DOCUMENT_HASH_OWNER = 'o', // owner hash in any supported algorithm
+    DOCUMENT_HASH_BATCH = 'm', // Merkle root of a document batch (SHA2-256)
+};
+
+/** Key of the secondary document indexes: type, algorithm id, raw hash bytes,
+ *  block height, transaction position and output. The hash width follows from the
+ *  algorithm id, so all keys for one hash share a common prefix. */
+struct CDocumentHashIndexKey {
+    unsigned char type;
+    unsigned char algo;
+    std::vector<unsigned char> hash;
+    int blockHeight;
+    unsigned int txindex;
+    unsigned int vout;
+
+    size_t GetSerializeSize() const {
+        return 2 + hash.size() + 12;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        ser_writedata8(s, algo);
+        s.write((const char*)hash.data(), hash.size());
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, txindex);
+        ser_writedata32be(s, vout);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        algo = ser_readdata8(s);
+        int nHexLength = CDocument::HashHexLength(algo);
+        if (nHexLength <= 0)
+            throw std::ios_base::failure("unknown document hash algorithm");
+        hash.resize(nHexLength / 2);
+        s.read((char*)hash.data(), hash.size());
+        blockHeight = ser_readdata32be(s);
+        txindex = ser_readdata32be(s);
+        vout = ser_readdata32be(s);
     }
 
-    CDocumentIndexIteratorKey(std::string sFileHash) {
-        std::transform(sFileHash.begin(), sFileHash.end(), sFileHash.begin(), ::tolower);
-        hashBytes.SetHex(sFileHash);
+    CDocumentHashIndexKey(unsigned char t, unsigned char a, const std::vector<unsigned char>& h, int height, int blockindex, unsigned int n) {
+        type = t;
+        algo = a;
+        hash = h;
+        blockHeight = height;
+        txindex = blockindex;
+        vout = n;
     }
 
-    CDocumentIndexIteratorKey() {
+    CDocumentHashIndexKey(unsigned char t, const CDocumentHashRef& h, int height, int blockindex, unsigned int n) {
+        type = t;
+        algo = h.algo;
+        hash.assign(h.begin(), h.end());
+        blockHeight = height;
+        txindex = blockindex;
+        vout = n;
+    }
+
+    CDocumentHashIndexKey() {
         SetNull();
     }
 
     void SetNull() {
-        hashBytes.SetNull();
+        type = 0;
+        algo = 0;
+        hash.clear();
+        blockHeight = 0;
+        txindex = 0;
+        vout = 0;
     }
 
-    std::string fileHash() const {
-        return hashBytes.ToString();
+    std::string hashHex() const {
+        return HexStr(hash);
+    }
+};
+
+struct CDocumentHashIndexIteratorKey {
+    unsigned char type;
+    unsigned char algo;
+    std::vector<unsigned char> hash;
+
+    size_t GetSerializeSize() const {
+        return 2 + hash.size();
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        ser_writedata8(s, algo);
+        s.write((const char*)hash.data(), hash.size());
+    }
+
+    CDocumentHashIndexIteratorKey(unsigned char t, unsigned char a, const std::vector<unsigned char>& h) {
+        type = t;
+        algo = a;
+        hash = h;
+    }
+};
+
+/** Unconfirmed document in the mempool, by the same hashes as the document hash index */
+struct CMempoolDocumentKey {
+    unsigned char type;
+    unsigned char algo;
+    std::vector<unsigned char> hash;
+    uint256 txhash;
+    unsigned int vout;
+
+    CMempoolDocumentKey(unsigned char t, unsigned char a, const std::vector<unsigned char>& h, const uint256& txid, unsigned int n) {
+        type = t;
+        algo = a;
+        hash = h;
+        txhash = txid;
+        vout = n;
+    }
+
+    CMempoolDocumentKey(unsigned char t, unsigned char a, const std::vector<unsigned char>& h) {
+        type = t;
+        algo = a;
+        hash = h;
+        txhash.SetNull();
+        vout = 0;
+    }
+};
+
+struct CMempoolDocumentKeyCompare
+{
+    bool operator()(const CMempoolDocumentKey& a, const CMempoolDocumentKey& b) const {
+        if (a.type != b.type)
+            return a.type < b.type;
+        if (a.algo != b.algo)
+            return a.algo < b.algo;
+        if (a.hash != b.hash)
+            return a.hash < b.hash;
+        if (a.txhash != b.txhash)
+            return a.txhash < b.txhash;
+        return a.vout < b.vout;
     }
 };
 
@@ -12,6 +12,7 @@
 #include "net_processing.h"
 #include "netmessagemaker.h"
 
+#include <atomic>
 #include <string>
 
 CSporkManager sporkManager;
@@ -154,6 +155,7 @@ void CSporkManager::ProcessSpork(CNode* pfrom, const std::string& strCommand, CD
         }
 
         {
+            // checked and stored under one lock, sporks are processed by several message handler threads
             LOCK(cs); // make sure to not lock this together with cs_main
             if (mapSporksActive.count(spork.nSporkID)) {
                 if (mapSporksActive[spork.nSporkID].count(keyIDSigner)) {
@@ -169,11 +171,7 @@ void CSporkManager::ProcessSpork(CNode* pfrom, const std::string& strCommand, CD
             } else {
                 LogPrintf("%s new\n", strLogMsg);
             }
-        }
-
 
-        {
-            LOCK(cs); // make sure to not lock this together with cs_main
             mapSporksByHash[hash] = spork;
             mapSporksActive[spork.nSporkID][keyIDSigner] = spork;
         }
@@ -205,10 +203,11 @@ void CSporkManager::ExecuteSpork(int nSporkID, int nValue)
         // this potentially can be a heavy operation, so only allow this to be executed once per 10 minutes
         int64_t nTimeout = 10 * 60;
 
-        static int64_t nTimeExecuted = 0; // i.e. it was never executed before
+        static std::atomic<int64_t> nTimeExecuted(0); // i.e. it was never executed before
 
-        if(GetTime() - nTimeExecuted < nTimeout) {
-            LogPrint("spork", "CSporkManager::ExecuteSpork -- ERROR: Trying to reconsider blocks, too soon - %d/%d\n", GetTime() - nTimeExecuted, nTimeout);
+        int64_t nTimeLastExecuted = nTimeExecuted;
+        if(GetTime() - nTimeLastExecuted < nTimeout) {
+            LogPrint("spork", "CSporkManager::ExecuteSpork -- ERROR: Trying to reconsider blocks, too soon - %d/%d\n", GetTime() - nTimeLastExecuted, nTimeout);
             return;
         }
 
@@ -217,11 +216,12 @@ void CSporkManager::ExecuteSpork(int nSporkID, int nValue)
             return;
         }
 
+        // claim the run first, so that two message handler threads do not reprocess at once
+        if(!nTimeExecuted.compare_exchange_strong(nTimeLastExecuted, GetTime())) return;
 
         LogPrintf("CSporkManager::ExecuteSpork -- Reconsider Last %d Blocks\n", nValue);
 
         ReprocessBlocks(nValue);
-        nTimeExecuted = GetTime();
     }
 }
 
@@ -7,7 +7,10 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <map>
+#include <mutex>
 #include <stdio.h>
+#include <tuple>
 
 #include <boost/foreach.hpp>
 #include <boost/thread.hpp>
@@ -19,6 +22,86 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+static thread_local int64_t nThreadCsMainWait = 0;
+// compared by address, a lock may be taken under any expression naming it
+static std::atomic<const void*> pcsMainWait(NULL);
+
+void RecordLockWait(const void* cs, int64_t nMicros)
+{
+    if (cs == pcsMainWait.load(std::memory_order_relaxed))
+        nThreadCsMainWait += nMicros;
+}
+
+void RegisterCsMainWait(const void* cs)
+{
+    pcsMainWait = cs;
+}
+
+int64_t GetThreadCsMainWait()
+{
+    return nThreadCsMainWait;
+}
+
+std::atomic<bool> fLockStats(DEFAULT_LOCKSTATS);
+
+namespace {
+
+// Sites are keyed by the string literals of the LOCK macro, which are unique per
+// call site, so recording needs no string compares. GetLockStats merges sites
+// whose file name literal the compiler did not pool.
+typedef std::tuple<const char*, const char*, int> LockSite;
+
+std::mutex csLockStats;
+std::map<LockSite, CLockSiteStats> mapLockStats;
+
+} // namespace
+
+void RecordLockSite(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWait, int64_t nHold)
+{
+    std::lock_guard<std::mutex> lock(csLockStats);
+    CLockSiteStats& stats = mapLockStats[LockSite(pszName, pszFile, nLine)];
+    stats.nAcquisitions++;
+    if (fContended)
+        stats.nContentions++;
+    stats.nWaitTime += nWait;
+    stats.nMaxWait = std::max(stats.nMaxWait, nWait);
+    stats.nHoldTime += nHold;
+    stats.nMaxHold = std::max(stats.nMaxHold, nHold);
+}
+
+std::vector<CLockSiteStats> GetLockStats(bool fReset)
+{
+    std::map<LockSite, CLockSiteStats> mapSites;
+    {
+        std::lock_guard<std::mutex> lock(csLockStats);
+        if (fReset)
+            mapSites.swap(mapLockStats);
+        else
+            mapSites = mapLockStats;
+    }
+
+    std::map<std::tuple<std::string, std::string, int>, CLockSiteStats> mapMerged;
+    for (const auto& entry : mapSites) {
+        CLockSiteStats& stats = mapMerged[std::make_tuple(std::string(std::get<0>(entry.first)), std::string(std::get<1>(entry.first)), std::get<2>(entry.first))];
+        stats.nAcquisitions += entry.second.nAcquisitions;
+        stats.nContentions += entry.second.nContentions;
+        stats.nWaitTime += entry.second.nWaitTime;
+        stats.nMaxWait = std::max(stats.nMaxWait, entry.second.nMaxWait);
+        stats.nHoldTime += entry.second.nHoldTime;
+        stats.nMaxHold = std::max(stats.nMaxHold, entry.second.nMaxHold);
+    }
+
+    std::vector<CLockSiteStats> vStats;
+    vStats.reserve(mapMerged.size());
+    for (auto& entry : mapMerged) {
+        entry.second.strName = std::get<0>(entry.first);
+        entry.second.strFile = std::get<1>(entry.first);
+        entry.second.nLine = std::get<2>(entry.first);
+        vStats.push_back(entry.second);
+    }
+    return vStats;
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
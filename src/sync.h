@@ -7,6 +7,11 @@
 #define BITCOIN_SYNC_H
 
 #include "threadsafety.h"
+#include "utiltime.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
 
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/locks.hpp>
@@ -108,6 +113,36 @@ typedef boost::condition_variable CConditionVariable;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/** Account the time a thread was blocked acquiring a contended lock */
+void RecordLockWait(const void* cs, int64_t nMicros);
+/** Register the address of cs_main, whose waits GetThreadCsMainWait sums up */
+void RegisterCsMainWait(const void* cs);
+/** Microseconds the calling thread has been blocked on cs_main so far */
+int64_t GetThreadCsMainWait();
+
+/** Default for -lockstats */
+static const bool DEFAULT_LOCKSTATS = false;
+/** Whether LOCK and TRY_LOCK acquisitions are profiled, set by -lockstats */
+extern std::atomic<bool> fLockStats;
+
+/** Acquisitions of one lock at one call site, times in microseconds */
+struct CLockSiteStats
+{
+    std::string strName;
+    std::string strFile;
+    int nLine = 0;
+    uint64_t nAcquisitions = 0;
+    uint64_t nContentions = 0;
+    int64_t nWaitTime = 0;
+    int64_t nMaxWait = 0;
+    int64_t nHoldTime = 0;
+    int64_t nMaxHold = 0;
+};
+
+void RecordLockSite(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWait, int64_t nHold);
+/** Statistics per call site, with fReset cleared in the same step so that no acquisition is lost or counted twice */
+std::vector<CLockSiteStats> GetLockStats(bool fReset = false);
+
 /** Wrapper around boost::unique_lock<Mutex> */
 template <typename Mutex>
 class SCOPED_LOCKABLE CMutexLock
@@ -115,17 +150,40 @@ class SCOPED_LOCKABLE CMutexLock
 private:
     boost::unique_lock<Mutex> lock;
 
+    // call site of an acquisition profiled by -lockstats, pszProfileName is NULL otherwise
+    const char* pszProfileName = NULL;
+    const char* pszProfileFile;
+    int nProfileLine;
+    bool fProfileContended;
+    int64_t nProfileWait;
+    int64_t nProfileLocked;
+
+    void StartProfile(const char* pszName, const char* pszFile, int nLine, bool fContended, int64_t nWait)
+    {
+        pszProfileName = pszName;
+        pszProfileFile = pszFile;
+        nProfileLine = nLine;
+        fProfileContended = fContended;
+        nProfileWait = nWait;
+        nProfileLocked = GetTimeMicros();
+    }
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
+        bool fContended = !lock.try_lock();
+        int64_t nWait = 0;
+        if (fContended) {
 #ifdef DEBUG_LOCKCONTENTION
-        if (!lock.try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
 #endif
+            int64_t nWaitStart = GetTimeMicros();
             lock.lock();
-#ifdef DEBUG_LOCKCONTENTION
+            nWait = GetTimeMicros() - nWaitStart;
+            RecordLockWait((void*)(lock.mutex()), nWait);
         }
-#endif
+        if (fLockStats.load(std::memory_order_relaxed))
+            StartProfile(pszName, pszFile, nLine, fContended, nWait);
     }
 
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
@@ -134,6 +192,8 @@ private:
         lock.try_lock();
         if (!lock.owns_lock())
             LeaveCritical();
+        else if (fLockStats.load(std::memory_order_relaxed))
+            StartProfile(pszName, pszFile, nLine, false, 0);
         return lock.owns_lock();
     }
 
@@ -159,8 +219,14 @@ public:
 
     ~CMutexLock() UNLOCK_FUNCTION()
     {
-        if (lock.owns_lock())
+        if (lock.owns_lock()) {
             LeaveCritical();
+            if (pszProfileName) {
+                int64_t nHold = GetTimeMicros() - nProfileLocked;
+                lock.unlock();
+                RecordLockSite(pszProfileName, pszProfileFile, nProfileLine, fProfileContended, nProfileWait, nHold);
+            }
+        }
     }
 
     operator bool()
@@ -7,6 +7,7 @@
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
 #include "crypto/sha512.h"
+#include "crypto/sha3.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
 #include "utilstrencodings.h"
@@ -56,6 +57,26 @@ void TestSHA256(const std::string &in, const std::string &hexout) { TestVector(C
 void TestSHA512(const std::string &in, const std::string &hexout) { TestVector(CSHA512(), in, ParseHex(hexout));}
 void TestRIPEMD160(const std::string &in, const std::string &hexout) { TestVector(CRIPEMD160(), in, ParseHex(hexout));}
 
+void TestSHA3(const std::string &in, const std::string &hexout) {
+    std::vector<unsigned char> out = ParseHex(hexout);
+    std::vector<unsigned char> hash(out.size());
+    CSHA3(out.size()).Write((unsigned char*)&in[0], in.size()).Finalize(&hash[0]);
+    BOOST_CHECK(hash == out);
+    for (int i=0; i<32; i++) {
+        // Test that writing the string broken up in random pieces works.
+        CSHA3 hasher(out.size());
+        size_t pos = 0;
+        while (pos < in.size()) {
+            size_t len = insecure_rand() % ((in.size() - pos + 1) / 2 + 1);
+            hasher.Write((unsigned char*)&in[pos], len);
+            pos += len;
+        }
+        hasher.Finalize(&hash[0]);
+        BOOST_CHECK(hash == out);
+        BOOST_CHECK(hasher.Reset().Write((unsigned char*)&in[0], in.size()).OutputSize() == out.size());
+    }
+}
+
 void TestHMACSHA256(const std::string &hexkey, const std::string &hexin, const std::string &hexout) {
     std::vector<unsigned char> key = ParseHex(hexkey);
     TestVector(CHMAC_SHA256(&key[0], key.size()), ParseHex(hexin), ParseHex(hexout));
@@ -217,6 +238,22 @@ BOOST_AUTO_TEST_CASE(ripemd160_testvectors) {
     TestRIPEMD160(test1, "464243587bd146ea835cdf57bdae582f25ec45f1");
 }
 
+BOOST_AUTO_TEST_CASE(sha3_testvectors) {
+    const std::string abc56 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    TestSHA3("", "6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7");
+    TestSHA3("abc", "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf");
+    TestSHA3(abc56, "8a24108b154ada21c9fd5574494479ba5c7e7ab76ef264ead0fcce33");
+    TestSHA3("", "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a");
+    TestSHA3("abc", "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532");
+    TestSHA3(abc56, "41c0dba2a9d6240849100376a8235e2c82e1b9998a999e21db32dd97496d3376");
+    TestSHA3(std::string(1000000, 'a'), "5c8875ae474a3634ba4fd55ec85bffd661f32aca75c6d699d0cdcb6c115891c1");
+    TestSHA3("", "0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2ac3713831264adb47fb6bd1e058d5f004");
+    TestSHA3("abc", "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b298d88cea927ac7f539f1edf228376d25");
+    TestSHA3("", "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26");
+    TestSHA3("abc", "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0");
+    TestSHA3(abc56, "04a371e84ecfb5b8b77cb48610fca8182dd457ce6f326a0fd3d7ec2f1e91636dee691fbe0c985302ba1b0d8dc78c086346b533b49c030d99a27daf1139d6e75e");
+}
+
 BOOST_AUTO_TEST_CASE(sha1_testvectors) {
     TestSHA1("", "da39a3ee5e6b4b0d3255bfef95601890afd80709");
     TestSHA1("abc", "a9993e364706816aba3e25717850c26c9cd0d89d");
@@ -0,0 +1,687 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "documentbatch.h"
+#include "documentfilter.h"
+#include "documenthash.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "primitives/document.h"
+#include "primitives/transaction.h"
+#include "random.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "txdb.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "test/test_dms.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(document_tests, BasicTestingSetup)
+
+static const std::string DOC_GUID  = "8C25CFE61D4B4F5E9A0B3C4A41D2C6F1";
+static const std::string DOC_MD5   = "0F343B0931126A20F133D67C2B018A3B";
+static const std::string DOC_SHA2  = "2B5CB5CE6A1DDBFA8B4A52B42E7E0FB7AE1AD4B9D1B3CBD33C5B02C7F2FBD6A8";
+static const std::string DOC_OWNER = "9F86D081884C7D659A2FEAA0C55AD015A3BF4F1B2B0B822CD15D6C15B0F00A08";
+
+static std::string CreateDocumentV2()
+{
+    return "444D2400020002"
+           "F000" + DOC_MD5 +
+           "0000" + DOC_GUID +
+           "F022" + DOC_SHA2 +
+           "B032" + DOC_OWNER;
+}
+
+static bool ParseDocument(const std::string& strHex, CDocumentRef& document)
+{
+    // the buffer outlives the returned references until the next call
+    static std::vector<unsigned char> data;
+    data = ParseHex(strHex);
+    return document.Parse(data.data(), data.data() + data.size());
+}
+
+BOOST_AUTO_TEST_CASE(document_parse)
+{
+    CDocumentRef document;
+    BOOST_CHECK(ParseDocument(CreateDocumentV2(), document));
+    BOOST_CHECK_EQUAL(document.version, 2);
+    BOOST_CHECK_EQUAL(HexStr(document.guid.begin(), document.guid.end()), HexStr(ParseHex(DOC_GUID)));
+    BOOST_CHECK_EQUAL(document.indexhash.algo, 0);
+    BOOST_CHECK_EQUAL(HexStr(document.indexhash.begin(), document.indexhash.end()), HexStr(ParseHex(DOC_MD5)));
+    BOOST_CHECK_EQUAL(document.filehash.algo, 22);
+    BOOST_CHECK_EQUAL(HexStr(document.filehash.begin(), document.filehash.end()), HexStr(ParseHex(DOC_SHA2)));
+    BOOST_CHECK_EQUAL(document.ownerhash.algo, 32);
+    BOOST_CHECK(document.attrhash.IsNull());
+
+    // version 1, owner hash only with the full length
+    std::string strV1 = "444D2400010002" + DOC_GUID + DOC_MD5 + DOC_MD5;
+    BOOST_CHECK(ParseDocument(strV1, document));
+    BOOST_CHECK_EQUAL(document.version, 1);
+    BOOST_CHECK(!document.attrhash.IsNull());
+    BOOST_CHECK(document.ownerhash.IsNull());
+    BOOST_CHECK(ParseDocument(strV1 + DOC_MD5, document));
+    BOOST_CHECK(!document.ownerhash.IsNull());
+
+    // malformed payloads
+    BOOST_CHECK(!ParseDocument("", document));
+    BOOST_CHECK(!ParseDocument("454D2400020002F000" + DOC_MD5, document));
+    BOOST_CHECK(!ParseDocument("444D2400010002" + DOC_GUID + DOC_MD5.substr(2), document));
+    BOOST_CHECK(!ParseDocument("444D2400020002F0A2" + DOC_MD5, document));
+
+    // a truncated hash is dropped, the complete ones are kept
+    BOOST_CHECK(ParseDocument(CreateDocumentV2().substr(0, CreateDocumentV2().size() - 2), document));
+    BOOST_CHECK(document.ownerhash.IsNull());
+    BOOST_CHECK(!document.filehash.IsNull());
+    std::string strLong = "444D2400020002";
+    for (int i = 0; i < 20; i++)
+        strLong += "A000" + DOC_MD5;
+    BOOST_CHECK(!ParseDocument(strLong, document));
+    BOOST_CHECK(document.indexhash.IsNull());
+
+    // the string based document is built from the same parser
+    CDocument doc(CreateDocumentV2());
+    BOOST_CHECK(doc.isvalid);
+    BOOST_CHECK_EQUAL(doc.version, 2);
+    BOOST_CHECK_EQUAL(doc.guidcompr, DOC_GUID);
+    BOOST_CHECK_EQUAL(doc.indexhash.hash, DOC_MD5);
+    BOOST_CHECK_EQUAL(doc.filehash.hash, DOC_SHA2);
+    BOOST_CHECK_EQUAL(doc.ownerhash.hash, DOC_OWNER);
+    BOOST_CHECK_EQUAL(doc.rawDocument, CreateDocumentV2());
+    BOOST_CHECK(!CDocument(strLong).isvalid);
+
+    // outputs with OP_PUSHDATA1 (version 2) and a direct push (version 1)
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CTxOut txout(0, CScript() << OP_RETURN << data);
+    BOOST_CHECK_EQUAL(txout.scriptPubKey[1], OP_PUSHDATA1);
+    BOOST_CHECK(txout.GetDocumentRef(document));
+    BOOST_CHECK(document.filehash.begin() == txout.scriptPubKey.data() + 3 + 7 + 18 + 18 + 2);
+    BOOST_CHECK(txout.GetDocument(doc));
+    BOOST_CHECK_EQUAL(doc.filehash.hash, DOC_SHA2);
+    txout = CTxOut(0, CScript() << OP_RETURN << ParseHex(strV1));
+    BOOST_CHECK(txout.GetDocumentRef(document));
+    BOOST_CHECK_EQUAL(document.version, 1);
+    BOOST_CHECK(!CTxOut(0, CScript() << OP_DUP << data).GetDocumentRef(document));
+    BOOST_CHECK(!CTxOut(0, CScript() << OP_RETURN).GetDocumentRef(document));
+    BOOST_CHECK(!CTxOut(0, CScript()).GetDocumentRef(document));
+}
+
+BOOST_AUTO_TEST_CASE(document_parse_random)
+{
+    // truncated and corrupted payloads never read outside the buffer
+    FastRandomContext rng(true);
+    const std::string strBase[3] = {CreateDocumentV2(), "444D2400010002" + DOC_GUID + DOC_MD5 + DOC_MD5 + DOC_MD5, "444D2400030002000000" "05" + DOC_SHA2};
+    for (int i = 0; i < 20000; i++) {
+        std::vector<unsigned char> data = ParseHex(strBase[i % 3]);
+        data.resize(rng.rand32(data.size() + 1));
+        for (int n = rng.rand32(4); n > 0 && !data.empty(); n--)
+            data[rng.rand32(data.size())] = rng.rand32(256);
+
+        CDocumentRef document;
+        if (!document.Parse(data.data(), data.data() + data.size()))
+            continue;
+        for (const CDocumentHashRef* hash : {&document.guid, &document.indexhash, &document.filehash, &document.attrhash, &document.ownerhash, &document.merkleroot}) {
+            if (hash->IsNull())
+                continue;
+            BOOST_CHECK(hash->begin() >= data.data() && hash->end() <= data.data() + data.size());
+            BOOST_CHECK_EQUAL((int)hash->size * 2, CDocument::HashHexLength(hash->algo));
+        }
+        BOOST_CHECK(CDocument(HexStr(data)).isvalid);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(document_hashindex_keys)
+{
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    BOOST_CHECK_EQUAL(document.version, 2);
+    BOOST_CHECK(CDocumentIndexKey(document.indexhash, 100, 3, 1) == CDocumentIndexKey(0, ParseHex(DOC_MD5), 100, 3, 1));
+
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vKeys;
+    CDocumentIndexValue value(uint256S("01"), 2);
+    GetDocumentHashIndexKeys(document, 100, 3, value, vKeys);
+    BOOST_CHECK_EQUAL(vKeys.size(), 4U);
+
+    BOOST_CHECK_EQUAL(vKeys[0].first.type, DOCUMENT_HASH_GUID);
+    BOOST_CHECK_EQUAL(vKeys[0].first.hashHex(), HexStr(ParseHex(DOC_GUID)));
+    BOOST_CHECK_EQUAL(vKeys[1].first.type, DOCUMENT_HASH_FILE);
+    BOOST_CHECK_EQUAL(vKeys[1].first.algo, 0);
+    BOOST_CHECK_EQUAL(vKeys[2].first.type, DOCUMENT_HASH_FILE);
+    BOOST_CHECK_EQUAL(vKeys[2].first.algo, 22);
+    BOOST_CHECK_EQUAL(vKeys[2].first.hash.size(), 32U);
+    BOOST_CHECK_EQUAL(vKeys[3].first.type, DOCUMENT_HASH_OWNER);
+    BOOST_CHECK_EQUAL(vKeys[3].first.algo, 32);
+    for (const auto& key : vKeys) {
+        BOOST_CHECK_EQUAL(key.first.blockHeight, 100);
+        BOOST_CHECK_EQUAL(key.first.txindex, 3U);
+        BOOST_CHECK(key.second == value);
+    }
+
+    // hashes missing from the document are not indexed
+    vKeys.clear();
+    data = ParseHex("444D2400020002" "F000" + DOC_MD5 + "F022" + DOC_SHA2);
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    GetDocumentHashIndexKeys(document, 100, 3, value, vKeys);
+    BOOST_CHECK_EQUAL(vKeys.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(document_hashindex_key_serialization)
+{
+    CDocumentHashIndexKey key(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), 123456, 7, 2);
+    CDataStream ssKey(SER_DISK, 0);
+    ssKey << key;
+    BOOST_CHECK_EQUAL(ssKey.size(), key.GetSerializeSize());
+
+    // the iterator key is a prefix of every key for the same hash
+    CDataStream ssPrefix(SER_DISK, 0);
+    ssPrefix << CDocumentHashIndexIteratorKey(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2));
+    BOOST_CHECK(std::equal(ssPrefix.begin(), ssPrefix.end(), ssKey.begin()));
+
+    CDocumentHashIndexKey key2;
+    ssKey >> key2;
+    BOOST_CHECK_EQUAL(key2.type, key.type);
+    BOOST_CHECK_EQUAL(key2.algo, key.algo);
+    BOOST_CHECK(key2.hash == key.hash);
+    BOOST_CHECK_EQUAL(key2.blockHeight, key.blockHeight);
+    BOOST_CHECK_EQUAL(key2.txindex, key.txindex);
+    BOOST_CHECK_EQUAL(key2.vout, key.vout);
+
+    // unknown algorithm ids cannot be read back
+    CDataStream ssBad(SER_DISK, 0);
+    ssBad << CDocumentHashIndexKey(DOCUMENT_HASH_FILE, 99, ParseHex(DOC_MD5), 1, 1, 0);
+    BOOST_CHECK_THROW(ssBad >> key2, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(document_index_key_serialization)
+{
+    CDocumentIndexKey key(22, ParseHex(DOC_SHA2), 123456, 7, 2);
+    CDataStream ssKey(SER_DISK, 0);
+    ssKey << key;
+    BOOST_CHECK_EQUAL(ssKey.size(), key.GetSerializeSize());
+    BOOST_CHECK_EQUAL(ssKey[0], (char)DOCUMENT_INDEX_KEY_VERSION);
+
+    // the iterator key is a prefix of every key for the same hash
+    CDataStream ssPrefix(SER_DISK, 0);
+    ssPrefix << CDocumentIndexIteratorKey(22, ParseHex(DOC_SHA2));
+    BOOST_CHECK(std::equal(ssPrefix.begin(), ssPrefix.end(), ssKey.begin()));
+
+    CDocumentIndexKey key2;
+    ssKey >> key2;
+    BOOST_CHECK(key2 == key);
+    BOOST_CHECK_EQUAL(key2.fileHash(), HexStr(ParseHex(DOC_SHA2)));
+
+    // keys of another version, e.g. an old cursor, cannot be read back
+    CDataStream ssOld(SER_DISK, 0);
+    ssOld << key;
+    ssOld[0] = DOCUMENT_INDEX_KEY_VERSION + 1;
+    BOOST_CHECK_THROW(ssOld >> key2, std::ios_base::failure);
+
+    // a document without an MD5 index hash is indexed by its file hash
+    std::vector<unsigned char> data = ParseHex("444D2400020002" "0000" + DOC_GUID + "F022" + DOC_SHA2);
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.n = 0;
+    tx.vout.push_back(CTxOut(1, CScript() << OP_TRUE));
+    tx.vout.push_back(CTxOut(0, CScript() << OP_RETURN << data));
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex;
+    GetDocumentIndexEntries(CTransaction(tx), 5, 2, vIndex, vHashIndex);
+    BOOST_CHECK_EQUAL(vIndex.size(), 1U);
+    BOOST_CHECK(vIndex[0].first == CDocumentIndexKey(22, ParseHex(DOC_SHA2), 5, 2, 1));
+}
+
+static int CountDocuments()
+{
+    int nCount = 0;
+    pblocktree->ReadDocumentIndex([&nCount](const CDocumentIndexKey&, const CDocumentIndexValue&) { nCount++; return true; });
+    return nCount;
+}
+
+BOOST_FIXTURE_TEST_CASE(document_index_connect_disconnect, TestingSetup)
+{
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex10, vIndex11;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex10, vHashIndex11;
+    vIndex10.push_back(std::make_pair(CDocumentIndexKey(0, ParseHex(DOC_MD5), 10, 1, 0), CDocumentIndexValue(uint256S("01"), 0)));
+    vIndex10.push_back(std::make_pair(CDocumentIndexKey(0, ParseHex(DOC_GUID), 10, 2, 0), CDocumentIndexValue(uint256S("02"), 0)));
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 0), vHashIndex10);
+    vIndex11.push_back(std::make_pair(CDocumentIndexKey(0, ParseHex(DOC_MD5), 11, 1, 0), CDocumentIndexValue(uint256S("03"), 0)));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 0);
+
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex10, vHashIndex10, 10));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 2);
+
+    // reconnecting the same height replaces its delta
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex10, vHashIndex10, 10));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 2);
+
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex11, vHashIndex11, 11));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 3);
+    BOOST_CHECK_EQUAL(CountDocuments(), 3);
+
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vFound;
+    BOOST_CHECK(pblocktree->ReadDocumentHashIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), vFound));
+    BOOST_CHECK_EQUAL(vFound.size(), 1U);
+
+    // disconnecting removes the entries and reverses the delta exactly once
+    BOOST_CHECK(pblocktree->EraseDocumentIndex(vIndex10, vHashIndex10, 10));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 1);
+    BOOST_CHECK(pblocktree->EraseDocumentIndex(vIndex10, vHashIndex10, 10));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 1);
+    BOOST_CHECK_EQUAL(CountDocuments(), 1);
+
+    vFound.clear();
+    BOOST_CHECK(pblocktree->ReadDocumentHashIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), vFound));
+    BOOST_CHECK(vFound.empty());
+
+    BOOST_CHECK(pblocktree->InitDocumentCount());
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(document_index_drop, TestingSetup)
+{
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex;
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 0), vHashIndex);
+    for (int i = 0; i < 100; i++)
+        vIndex.push_back(std::make_pair(CDocumentIndexKey(0, ParseHex(DOC_MD5), 10, i, 0), CDocumentIndexValue(uint256S("01"), 0)));
+    BOOST_CHECK(!pblocktree->HasDocumentIndexData());
+
+    // the background indexer writes its locator in the same batch as the entries
+    CBlockLocator locator(std::vector<uint256>(1, uint256S("05")));
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex, vHashIndex, 10, &locator));
+    CBlockLocator locatorRead;
+    BOOST_CHECK(pblocktree->ReadDocumentIndexBest(locatorRead));
+    BOOST_CHECK(locatorRead.vHave == locator.vHave);
+    BOOST_CHECK(pblocktree->HasDocumentIndexData());
+
+    BOOST_CHECK(pblocktree->EraseDocumentIndexData());
+    BOOST_CHECK(!pblocktree->HasDocumentIndexData());
+    BOOST_CHECK(!pblocktree->ReadDocumentIndexBest(locatorRead));
+    BOOST_CHECK_EQUAL(pblocktree->ReadDocumentCount(), 0);
+    BOOST_CHECK_EQUAL(CountDocuments(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(document_index_filter, TestingSetup)
+{
+    // SHA2-256 and SHA3-256 hashes have the same length, a filter finds both
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex;
+    vIndex.push_back(std::make_pair(CDocumentIndexKey(0, ParseHex(DOC_MD5), 10, 1, 0), CDocumentIndexValue(uint256S("01"), 0)));
+    vIndex.push_back(std::make_pair(CDocumentIndexKey(22, ParseHex(DOC_SHA2), 10, 2, 0), CDocumentIndexValue(uint256S("02"), 0)));
+    vIndex.push_back(std::make_pair(CDocumentIndexKey(32, ParseHex(DOC_SHA2), 10, 3, 1), CDocumentIndexValue(uint256S("03"), 1)));
+    vIndex.push_back(std::make_pair(CDocumentIndexKey(32, ParseHex(DOC_OWNER), 10, 4, 0), CDocumentIndexValue(uint256S("04"), 0)));
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex, vHashIndex, 10));
+
+    std::vector<CDocumentIndexKey> vFound;
+    auto visitor = [&vFound](const CDocumentIndexKey& key, const CDocumentIndexValue&) { vFound.push_back(key); return vFound.size() < 2; };
+    BOOST_CHECK(pblocktree->ReadDocumentIndex(visitor, DOC_SHA2));
+    BOOST_CHECK_EQUAL(vFound.size(), 2U);
+    BOOST_CHECK(vFound[0] == vIndex[1].first);
+    BOOST_CHECK(vFound[1] == vIndex[2].first);
+
+    // continuing after the first entry crosses over to the next algorithm only
+    vFound.clear();
+    BOOST_CHECK(pblocktree->ReadDocumentIndex(visitor, DOC_SHA2, &vIndex[1].first));
+    BOOST_CHECK_EQUAL(vFound.size(), 1U);
+    BOOST_CHECK(vFound[0] == vIndex[2].first);
+
+    vFound.clear();
+    BOOST_CHECK(pblocktree->ReadDocumentIndex(visitor, DOC_MD5));
+    BOOST_CHECK_EQUAL(vFound.size(), 1U);
+    BOOST_CHECK_EQUAL(CountDocuments(), 4);
+
+    // an index with the old keys is detected and dropped completely
+    BOOST_CHECK(!pblocktree->HasLegacyDocumentIndex());
+    CLegacyDocumentIndexKey legacyKey;
+    legacyKey.hashBytes.SetHex(DOC_MD5);
+    legacyKey.blockHeight = 10;
+    legacyKey.txindex = 1;
+    BOOST_CHECK(pblocktree->Write(std::make_pair('d', legacyKey), uint256S("01").ToString()));
+    BOOST_CHECK(pblocktree->HasLegacyDocumentIndex());
+    BOOST_CHECK(pblocktree->EraseDocumentIndexData());
+    BOOST_CHECK(!pblocktree->HasLegacyDocumentIndex());
+    BOOST_CHECK(!pblocktree->HasDocumentIndexData());
+}
+
+BOOST_FIXTURE_TEST_CASE(document_hashindex_outputs, TestingSetup)
+{
+    // the same document in two outputs of one transaction gets two entries
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex;
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 0), vHashIndex);
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 2), vHashIndex);
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex, vHashIndex, 10));
+
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vFound;
+    BOOST_CHECK(pblocktree->ReadDocumentHashIndex(DOCUMENT_HASH_OWNER, 32, ParseHex(DOC_OWNER), vFound));
+    BOOST_CHECK_EQUAL(vFound.size(), 2U);
+    BOOST_CHECK_EQUAL(vFound[0].first.vout, 0U);
+    BOOST_CHECK(vFound[0].second == CDocumentIndexValue(uint256S("01"), 0));
+    BOOST_CHECK_EQUAL(vFound[1].first.vout, 2U);
+    BOOST_CHECK(vFound[1].second == CDocumentIndexValue(uint256S("01"), 2));
+
+    // a disconnected block removes both
+    BOOST_CHECK(pblocktree->EraseDocumentIndex(vIndex, vHashIndex, 10));
+    vFound.clear();
+    BOOST_CHECK(pblocktree->ReadDocumentHashIndex(DOCUMENT_HASH_OWNER, 32, ParseHex(DOC_OWNER), vFound));
+    BOOST_CHECK(vFound.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(document_hashindex_bulk_read, TestingSetup)
+{
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > vIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vHashIndex;
+    std::vector<unsigned char> data = ParseHex(CreateDocumentV2());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(data.data(), data.data() + data.size()));
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 0), vHashIndex);
+    GetDocumentHashIndexKeys(document, 12, 3, CDocumentIndexValue(uint256S("02"), 0), vHashIndex);
+    BOOST_CHECK(pblocktree->WriteDocumentIndex(vIndex, vHashIndex, 10));
+
+    // unsorted, duplicate and unknown keys are answered in request order
+    std::vector<CDocumentHashIndexIteratorKey> keys;
+    keys.push_back(CDocumentHashIndexIteratorKey(DOCUMENT_HASH_GUID, 0, ParseHex(DOC_GUID)));
+    keys.push_back(CDocumentHashIndexIteratorKey(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2)));
+    keys.push_back(CDocumentHashIndexIteratorKey(DOCUMENT_HASH_FILE, 0, ParseHex(DOC_OWNER)));
+    keys.push_back(CDocumentHashIndexIteratorKey(DOCUMENT_HASH_FILE, 0, ParseHex(DOC_MD5)));
+    keys.push_back(CDocumentHashIndexIteratorKey(DOCUMENT_HASH_GUID, 0, ParseHex(DOC_GUID)));
+
+    std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > > vFound;
+    BOOST_CHECK(pblocktree->ReadDocumentHashIndex(keys, vFound));
+    BOOST_CHECK_EQUAL(vFound.size(), keys.size());
+    BOOST_CHECK(vFound[2].empty());
+    for (size_t i : {0, 1, 3, 4}) {
+        BOOST_CHECK_EQUAL(vFound[i].size(), 2U);
+        BOOST_CHECK_EQUAL(vFound[i][0].first.blockHeight, 10);
+        BOOST_CHECK_EQUAL(vFound[i][1].first.blockHeight, 12);
+        BOOST_CHECK(vFound[i][1].second.txhash == uint256S("02"));
+    }
+
+    // same result as one lookup per key
+    for (size_t i = 0; i < keys.size(); i++) {
+        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vSingle;
+        BOOST_CHECK(pblocktree->ReadDocumentHashIndex(keys[i].type, keys[i].algo, keys[i].hash, vSingle));
+        BOOST_CHECK_EQUAL(vSingle.size(), vFound[i].size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(document_mempool_index)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(uint256S("01"), 0);
+    tx.vout.push_back(CTxOut(0, CScript() << OP_RETURN << ParseHex(CreateDocumentV2())));
+    tx.vout.push_back(CTxOut(1000, CScript() << OP_TRUE));
+    CTransaction doctx(tx);
+
+    pool.addUnchecked(doctx.GetHash(), entry.Time(42).FromTx(doctx));
+    pool.addDocumentIndex(entry.FromTx(doctx));
+
+    std::vector<std::pair<CMempoolDocumentKey, int64_t> > results;
+    BOOST_CHECK(pool.getDocumentIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), results));
+    BOOST_CHECK_EQUAL(results.size(), 1U);
+    BOOST_CHECK(results[0].first.txhash == doctx.GetHash());
+    BOOST_CHECK_EQUAL(results[0].first.vout, 0U);
+    BOOST_CHECK_EQUAL(results[0].second, 42);
+
+    results.clear();
+    pool.getDocumentIndex(DOCUMENT_HASH_GUID, 0, ParseHex(DOC_GUID), results);
+    BOOST_CHECK_EQUAL(results.size(), 1U);
+    results.clear();
+    pool.getDocumentIndex(DOCUMENT_HASH_FILE, 0, std::vector<unsigned char>(), results);
+    BOOST_CHECK_EQUAL(results.size(), 1U);
+    BOOST_CHECK_EQUAL(HexStr(results[0].first.hash), HexStr(ParseHex(DOC_MD5)));
+    results.clear();
+    pool.getDocumentIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_OWNER), results);
+    BOOST_CHECK(results.empty());
+
+    // leaving the mempool, e.g. when mined, removes the entries
+    pool.removeRecursive(doctx);
+    pool.getDocumentIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), results);
+    BOOST_CHECK(results.empty());
+
+    // transactions accepted before the index was enabled are indexed when it is, once
+    pool.addUnchecked(doctx.GetHash(), entry.Time(43).FromTx(doctx));
+    pool.getDocumentIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), results);
+    BOOST_CHECK(results.empty());
+    pool.addDocumentIndexes();
+    pool.addDocumentIndexes();
+    pool.getDocumentIndex(DOCUMENT_HASH_FILE, 22, ParseHex(DOC_SHA2), results);
+    BOOST_CHECK_EQUAL(results.size(), 1U);
+    BOOST_CHECK_EQUAL(results[0].second, 43);
+}
+
+BOOST_AUTO_TEST_CASE(document_batch_merkle)
+{
+    std::vector<uint256> leaves;
+    for (int n = 1; n <= 17; n++) {
+        leaves.push_back(DocumentBatchLeaf(22, ParseHex(strprintf("%064x", n))));
+        uint256 root = ComputeDocumentBatchRoot(leaves);
+        for (int i = 0; i < n; i++) {
+            std::vector<uint256> branch = ComputeDocumentBatchBranch(leaves, i);
+            BOOST_CHECK(DocumentBatchRootFromBranch(leaves[i], branch, i, n) == root);
+            // a proof does not hold for another position
+            if (n > 1)
+                BOOST_CHECK(DocumentBatchRootFromBranch(leaves[i], branch, (i + 1) % n, n) != root);
+        }
+    }
+    // leaves are bound to the algorithm
+    BOOST_CHECK(DocumentBatchLeaf(22, ParseHex(DOC_SHA2)) != DocumentBatchLeaf(32, ParseHex(DOC_SHA2)));
+
+    // the anchor output is a version 3 document indexed by its root
+    uint256 root = ComputeDocumentBatchRoot(leaves);
+    std::vector<unsigned char> payload = DocumentBatchPayload(root, leaves.size());
+    CDocumentRef document;
+    BOOST_CHECK(document.Parse(payload.data(), payload.data() + payload.size()));
+    BOOST_CHECK_EQUAL(document.version, 3);
+    BOOST_CHECK_EQUAL(document.merklecount, leaves.size());
+    BOOST_CHECK_EQUAL(document.merkleroot.algo, 22);
+    BOOST_CHECK(std::equal(root.begin(), root.end(), document.merkleroot.begin()));
+
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vKeys;
+    GetDocumentHashIndexKeys(document, 10, 1, CDocumentIndexValue(uint256S("01"), 0), vKeys);
+    BOOST_CHECK_EQUAL(vKeys.size(), 1);
+    BOOST_CHECK_EQUAL(vKeys[0].first.type, DOCUMENT_HASH_BATCH);
+    BOOST_CHECK(vKeys[0].first.hash == std::vector<unsigned char>(root.begin(), root.end()));
+}
+
+BOOST_AUTO_TEST_CASE(document_batcher)
+{
+    CDocumentBatcher batcher(1 << 20, true);
+    uint32_t nIndex;
+    std::string strError;
+    BOOST_CHECK(!batcher.AddDocument(22, ParseHex(DOC_MD5), nIndex, strError));
+    for (int i = 0; i < 5; i++) {
+        BOOST_CHECK(batcher.AddDocument(22, ParseHex(strprintf("%064x", i)), nIndex, strError));
+        BOOST_CHECK_EQUAL(nIndex, i);
+    }
+
+    uint256 root;
+    uint32_t nCount;
+    std::vector<unsigned char> payload;
+    BOOST_CHECK(batcher.GetPendingBatch(root, nCount, payload));
+    BOOST_CHECK_EQUAL(nCount, 5);
+
+    // a document queued while the anchor is sent stays pending
+    BOOST_CHECK(batcher.AddDocument(22, ParseHex(DOC_SHA2), nIndex, strError));
+    BOOST_CHECK(batcher.CommitPendingBatch(root, nCount, uint256S("aa")));
+    BOOST_CHECK_EQUAL(batcher.GetPendingCount(), 1);
+
+    CDocumentBatchProof proof;
+    BOOST_CHECK(batcher.GetProof(DocumentBatchLeaf(22, ParseHex(strprintf("%064x", 3))), proof));
+    BOOST_CHECK(proof.root == root);
+    BOOST_CHECK(proof.txid == uint256S("aa"));
+    BOOST_CHECK_EQUAL(proof.nIndex, 3);
+    BOOST_CHECK_EQUAL(proof.nCount, 5);
+    BOOST_CHECK(DocumentBatchRootFromBranch(proof.leaf, proof.vBranch, proof.nIndex, proof.nCount) == root);
+
+    BOOST_CHECK(batcher.GetProof(DocumentBatchLeaf(22, ParseHex(DOC_SHA2)), proof));
+    BOOST_CHECK(proof.txid.IsNull());
+    BOOST_CHECK_EQUAL(proof.nIndex, 0);
+    BOOST_CHECK_EQUAL(proof.nCount, 1);
+    BOOST_CHECK(!batcher.GetProof(DocumentBatchLeaf(32, ParseHex(DOC_SHA2)), proof));
+
+    // a batch whose transaction was not sent returns to the front of the queue
+    BOOST_CHECK(batcher.GetPendingBatch(root, nCount, payload));
+    BOOST_CHECK(batcher.AddDocument(22, ParseHex(strprintf("%064x", 3)), nIndex, strError));
+    BOOST_CHECK(batcher.CommitPendingBatch(root, nCount, uint256S("bb")));
+    BOOST_CHECK(!batcher.CommitPendingBatch(root, nCount, uint256S("bb")));
+    BOOST_CHECK_EQUAL(batcher.GetPendingCount(), 1);
+    BOOST_CHECK(batcher.RevertBatch(root));
+    BOOST_CHECK(!batcher.RevertBatch(root));
+    BOOST_CHECK_EQUAL(batcher.GetPendingCount(), 2);
+    BOOST_CHECK(batcher.GetProof(DocumentBatchLeaf(22, ParseHex(DOC_SHA2)), proof));
+    BOOST_CHECK(proof.txid.IsNull());
+    BOOST_CHECK_EQUAL(proof.nIndex, 0);
+    BOOST_CHECK_EQUAL(proof.nCount, 2);
+
+    // a document anchored again keeps its first batch, which proves the earliest time
+    SetMockTime(GetTime() + 60);
+    BOOST_CHECK(batcher.GetPendingBatch(root, nCount, payload));
+    BOOST_CHECK(batcher.CommitPendingBatch(root, nCount, uint256S("cc")));
+    BOOST_CHECK(batcher.GetProof(DocumentBatchLeaf(22, ParseHex(strprintf("%064x", 3))), proof));
+    BOOST_CHECK(proof.txid == uint256S("aa"));
+    BOOST_CHECK_EQUAL(proof.nCount, 5);
+    BOOST_CHECK(batcher.GetProof(DocumentBatchLeaf(22, ParseHex(DOC_SHA2)), proof));
+    BOOST_CHECK(proof.txid == uint256S("cc"));
+    SetMockTime(0);
+}
+
+BOOST_FIXTURE_TEST_CASE(document_index_anchor_block, TestChain100Setup)
+{
+    // a block whose only document output is a batch anchor
+    std::vector<uint256> leaves(1, DocumentBatchLeaf(22, ParseHex(DOC_SHA2)));
+    uint256 root = ComputeDocumentBatchRoot(leaves);
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    tx.vout.push_back(CTxOut(0, CScript() << OP_RETURN << DocumentBatchPayload(root, leaves.size())));
+    tx.vout.push_back(CTxOut(11 * CENT, scriptPubKey));
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig << vchSig;
+
+    fDocumentIndex = true;
+    CBlock block = CreateAndProcessBlock(std::vector<CMutableTransaction>(1, tx), scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > vFound;
+    BOOST_CHECK(GetDocumentsByHash(DOCUMENT_HASH_BATCH, 22, HexStr(root.begin(), root.end()), vFound));
+    BOOST_CHECK_EQUAL(vFound.size(), 1U);
+    if (!vFound.empty()) {
+        BOOST_CHECK_EQUAL(vFound[0].first.blockHeight, chainActive.Height());
+        BOOST_CHECK(vFound[0].second == CDocumentIndexValue(tx.GetHash(), 0));
+    }
+    fDocumentIndex = false;
+}
+
+BOOST_FIXTURE_TEST_CASE(document_file_hashes, TestingSetup)
+{
+    // larger than one read, so the hashers see several writes
+    std::string strFile = (pathTemp / "document.bin").string();
+    FILE* file = fopen(strFile.c_str(), "wb");
+    BOOST_CHECK(file);
+    std::string data(3000000, 'a');
+    BOOST_CHECK_EQUAL(fwrite(data.data(), 1, data.size(), file), data.size());
+    fclose(file);
+
+    std::vector<CDocumentFileHashes> vFiles;
+    vFiles.push_back(CDocumentFileHashes(strFile));
+    vFiles.push_back(CDocumentFileHashes((pathTemp / "missing.bin").string()));
+    vFiles.push_back(CDocumentFileHashes(strFile));
+    HashDocumentFiles(vFiles, {0, 22, 32}, 2);
+
+    BOOST_CHECK(vFiles[0].strError.empty());
+    BOOST_CHECK_EQUAL(vFiles[0].nSize, data.size());
+    BOOST_CHECK_EQUAL(vFiles[0].vHashes.size(), 3U);
+    BOOST_CHECK_EQUAL(HexStr(vFiles[0].vHashes[0]), "99ddc9a3a46ea62c95652bdf937a1fb8");
+    BOOST_CHECK_EQUAL(HexStr(vFiles[0].vHashes[1]), "2a152c894398719c0570f83fac34ac03a0f6e8e474b995c2403aa5434f7b9dd4");
+    BOOST_CHECK_EQUAL(HexStr(vFiles[0].vHashes[2]), "1f74453d8f1b9e9df167562b955a00a0ede77000b11f0b63b85d9394e679336a");
+    BOOST_CHECK(!vFiles[1].strError.empty());
+    BOOST_CHECK(vFiles[1].vHashes.empty());
+    BOOST_CHECK(vFiles[2].vHashes == vFiles[0].vHashes);
+
+    CDocumentFileHashes unsupported(strFile);
+    BOOST_CHECK(!IsDocumentHashAlgoSupported(2));
+    BOOST_CHECK(!HashDocumentFile(unsupported, {0, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(document_filter)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.push_back(CTxOut(0, CScript() << OP_RETURN << ParseHex(CreateDocumentV2())));
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(uint256S("01"), 0);
+    tx.vout.push_back(CTxOut(1000, CScript() << OP_TRUE));
+    tx.vout.push_back(CTxOut(0, CScript() << OP_RETURN << ParseHex(CreateDocumentV2())));
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    // GUID, MD5, SHA2 and owner hash once each, the coinbase is not scanned
+    std::vector<CDocumentFilter::Element> vElements = GetDocumentFilterElements(block);
+    BOOST_CHECK_EQUAL(vElements.size(), 4U);
+    BOOST_CHECK(std::find(vElements.begin(), vElements.end(), ParseHex(DOC_SHA2)) != vElements.end());
+
+    const uint256 blockHash = GetRandHash();
+    CDocumentFilter filter(blockHash, vElements);
+    BOOST_CHECK_EQUAL(filter.GetN(), 4U);
+    for (const CDocumentFilter::Element& element : vElements)
+        BOOST_CHECK(filter.Match(element));
+    BOOST_CHECK(filter.MatchAny({ParseHex("00"), ParseHex(DOC_OWNER)}));
+
+    // decoding gives the same set
+    CDocumentFilter decoded(blockHash, filter.GetEncoded());
+    BOOST_CHECK_EQUAL(decoded.GetN(), 4U);
+    BOOST_CHECK(decoded.GetHash() == filter.GetHash());
+    for (const CDocumentFilter::Element& element : vElements)
+        BOOST_CHECK(decoded.Match(element));
+
+    // false positive rate 1/784931
+    int nFalsePositives = 0;
+    for (int i = 0; i < 10000; i++) {
+        uint256 hash = GetRandHash();
+        nFalsePositives += filter.Match(CDocumentFilter::Element(hash.begin(), hash.end()));
+    }
+    BOOST_CHECK(nFalsePositives < 3);
+
+    // a block without documents costs a single byte
+    CDocumentFilter empty(blockHash, std::vector<CDocumentFilter::Element>());
+    BOOST_CHECK_EQUAL(HexStr(empty.GetEncoded()), "00");
+    BOOST_CHECK(!empty.Match(ParseHex(DOC_SHA2)));
+
+    // truncated filters are rejected
+    std::vector<unsigned char> vTruncated(filter.GetEncoded().begin(), filter.GetEncoded().end() - 2);
+    BOOST_CHECK_THROW(CDocumentFilter(blockHash, vTruncated), std::ios_base::failure);
+    BOOST_CHECK_THROW(CDocumentFilter(blockHash, std::vector<unsigned char>()), std::ios_base::failure);
+
+    // the header commits to the filter and the previous header
+    uint256 filterHash = filter.GetHash();
+    uint256 prevHeader = GetRandHash();
+    BOOST_CHECK(filter.ComputeHeader(prevHeader) == Hash(filterHash.begin(), filterHash.end(), prevHeader.begin(), prevHeader.end()));
+    BOOST_CHECK(filter.ComputeHeader(prevHeader) != empty.ComputeHeader(prevHeader));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
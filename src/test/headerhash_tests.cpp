@@ -0,0 +1,98 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "hash.h"
+#include "headerhash.h"
+#include "streams.h"
+#include "validation.h"
+#include "test/test_dms.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(headerhash_tests, BasicTestingSetup)
+
+static std::vector<CBlockHeader> CreateHeaders(size_t count)
+{
+    std::vector<CBlockHeader> headers(count);
+    uint256 hashPrev;
+    for (size_t i = 0; i < count; i++) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].hashPrevBlock = hashPrev;
+        headers[i].nTime = 1546300800 + i * 150;
+        headers[i].nBits = 0x207fffff;
+        headers[i].nNonce = i;
+        hashPrev = headers[i].GetHash();
+    }
+    return headers;
+}
+
+BOOST_AUTO_TEST_CASE(headerhash_parallel)
+{
+    std::vector<CBlockHeader> headers = CreateHeaders(100);
+
+    // without a running pool the headers are hashed on the calling thread
+    std::vector<uint256> hashes = HashBlockHeaders(headers);
+    BOOST_CHECK_EQUAL(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+    }
+
+    CHeaderHashWorker worker(3);
+    BOOST_CHECK(worker.HashHeaders(headers) == hashes);
+    BOOST_CHECK(worker.HashHeaders(std::vector<CBlockHeader>(headers.begin(), headers.begin() + 1)) == std::vector<uint256>(1, hashes[0]));
+    BOOST_CHECK(worker.HashHeaders(std::vector<CBlockHeader>()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(headerhash_memoized)
+{
+    CBlockHeader header = CreateHeaders(1)[0];
+    uint256 hash = header.GetHash();
+    BOOST_CHECK(hash == SerializeHashYescrypt(header));
+    BOOST_CHECK(header.GetHash() == hash);
+
+    // copies share the cached hash, but must not return it once they are modified
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == hash);
+    block.nNonce++;
+    BOOST_CHECK(block.GetHash() == SerializeHashYescrypt(block.GetBlockHeader()));
+    BOOST_CHECK(block.GetHash() != hash);
+    BOOST_CHECK(header.GetHash() == hash);
+
+    header.hashMerkleRoot = uint256S("0x01");
+    BOOST_CHECK(header.GetHash() == SerializeHashYescrypt(header));
+    header.nTime++;
+    BOOST_CHECK(header.GetHash() == SerializeHashYescrypt(header));
+    header = block;
+    BOOST_CHECK(header.GetHash() == block.GetHash());
+
+    header.SetNull();
+    BOOST_CHECK(header.GetHash() == SerializeHashYescrypt(header));
+}
+
+BOOST_FIXTURE_TEST_CASE(headerhash_accept_path, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CBlock mined = CreateBlock(std::vector<CMutableTransaction>(), scriptPubKey);
+
+    // a block as received from the network, with nothing cached yet
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << mined;
+    auto pblock = std::make_shared<CBlock>();
+    ss >> *pblock;
+
+    uint64_t nCalls = CBlockHeader::GetHashCalls();
+    uint64_t nComputations = CBlockHeader::GetHashComputations();
+    BOOST_CHECK(ProcessNewBlock(Params(), pblock, true, NULL));
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == mined.GetHash());
+    nCalls = CBlockHeader::GetHashCalls() - nCalls;
+    nComputations = CBlockHeader::GetHashComputations() - nComputations;
+
+    // the accept path asks for the hash several times, but runs yescrypt once
+    BOOST_TEST_MESSAGE(strprintf("accepting a block: %d GetHash calls, %d yescrypt runs", nCalls, nComputations));
+    BOOST_CHECK(nCalls > 1);
+    BOOST_CHECK_EQUAL(nComputations, 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
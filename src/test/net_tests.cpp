@@ -12,6 +12,7 @@
 #include "streams.h"
 #include "net.h"
 #include "netbase.h"
+#include "netstats.h"
 #include "chainparams.h"
 
 class CAddrManSerializationMock : public CAddrMan
@@ -174,4 +175,79 @@ BOOST_AUTO_TEST_CASE(cnode_simple_test)
     BOOST_CHECK(pnode2->fFeeler == false);
 }
 
+BOOST_AUTO_TEST_CASE(cnetmessage_receive_in_place)
+{
+    // a large message, received partly through readData and partly in place
+    std::vector<unsigned char> vPayload(3 * RECV_BUFFER_SIZE + 1234);
+    for (size_t i = 0; i < vPayload.size(); i++)
+        vPayload[i] = i * 7;
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    ssHeader << CMessageHeader(Params().MessageStart(), NetMsgType::BLOCK, vPayload.size());
+
+    CNetMessage msg(Params().MessageStart(), SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(msg.readHeader(&ssHeader[0], ssHeader.size()), (int)CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(msg.in_data);
+
+    size_t nPos = 0;
+    BOOST_CHECK_EQUAL(msg.readData((const char*)&vPayload[0], 1000), 1000);
+    nPos += 1000;
+    while (!msg.complete()) {
+        unsigned int nSpace = RECV_BUFFER_SIZE;
+        char* pch = msg.PrepareData(nSpace);
+        BOOST_CHECK(nSpace > 0 && nSpace <= vPayload.size() - nPos);
+        memcpy(pch, &vPayload[nPos], nSpace);
+        msg.CommitData(nSpace);
+        nPos += nSpace;
+    }
+
+    BOOST_CHECK_EQUAL(nPos, vPayload.size());
+    BOOST_CHECK(std::equal(vPayload.begin(), vPayload.end(), (const unsigned char*)&msg.vRecv[0]));
+    BOOST_CHECK(msg.GetMessageHash() == Hash(vPayload.begin(), vPayload.end()));
+}
+
+BOOST_AUTO_TEST_CASE(time_histogram)
+{
+    CTimeHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.GetPercentile(99), 0);
+
+    // small values are exact
+    for (int64_t i = 1; i <= 7; i++)
+        histogram.Add(i);
+    BOOST_CHECK_EQUAL(histogram.GetPercentile(50), 4);
+    BOOST_CHECK_EQUAL(histogram.GetPercentile(100), 7);
+
+    // larger ones are rounded up to their bucket, within 25%
+    histogram.Clear();
+    for (int64_t i = 1; i <= 1000; i++)
+        histogram.Add(i * 1000);
+    BOOST_CHECK_EQUAL(histogram.GetCount(), 1000U);
+    BOOST_CHECK_EQUAL(histogram.GetTotal(), 500500000);
+    BOOST_CHECK_EQUAL(histogram.GetMax(), 1000000);
+    int64_t nP50 = histogram.GetPercentile(50);
+    BOOST_CHECK(nP50 >= 500000 && nP50 <= 625000);
+    int64_t nP99 = histogram.GetPercentile(99);
+    BOOST_CHECK(nP99 >= 990000 && nP99 <= 1000000);
+}
+
+BOOST_AUTO_TEST_CASE(netstats_commands)
+{
+    CNetStats stats;
+    stats.RecordMessage(NetMsgType::INV, 37, 120, 20);
+    stats.RecordMessage(NetMsgType::INV, 37, 80, 0);
+    stats.RecordMessage("nonsense", 10, 5, 0);
+    stats.RecordMessage("garbage", 10, 5, 0);
+
+    std::map<std::string, CNetCommandStats> mapStats = stats.GetCommandStats();
+    BOOST_CHECK_EQUAL(mapStats.size(), 2U);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::INV].timeProcess.GetCount(), 2U);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::INV].timeProcess.GetTotal(), 200);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::INV].nBytes, 74U);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::INV].nLockWait, 20);
+    BOOST_CHECK_EQUAL(mapStats["*other*"].timeProcess.GetCount(), 2U);
+
+    // reset returns the statistics it clears
+    BOOST_CHECK_EQUAL(stats.GetCommandStats(true).size(), 2U);
+    BOOST_CHECK(stats.GetCommandStats().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
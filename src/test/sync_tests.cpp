@@ -0,0 +1,76 @@
+// Copyright (c) 2021 The Documentchain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sync.h"
+#include "test/test_dms.h"
+#include "utiltime.h"
+
+#include <atomic>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(sync_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lockstats_sites)
+{
+    CCriticalSection csTest;
+    GetLockStats(true);
+    fLockStats = true;
+    int nLine = __LINE__ + 2;
+    for (int i = 0; i < 3; i++) {
+        LOCK(csTest);
+    }
+    {
+        TRY_LOCK(csTest, lockTest);
+        bool fLocked = lockTest;
+        BOOST_CHECK(fLocked);
+    }
+    fLockStats = false;
+    {
+        LOCK(csTest);
+    }
+
+    int nSites = 0;
+    for (const CLockSiteStats& stats : GetLockStats()) {
+        if (stats.strName != "csTest")
+            continue;
+        nSites++;
+        BOOST_CHECK_EQUAL(stats.nContentions, 0U);
+        BOOST_CHECK_EQUAL(stats.nWaitTime, 0);
+        BOOST_CHECK_EQUAL(stats.nAcquisitions, stats.nLine == nLine ? 3U : 1U);
+    }
+    BOOST_CHECK_EQUAL(nSites, 2);
+
+    // reset returns the statistics it clears
+    BOOST_CHECK(!GetLockStats(true).empty());
+    BOOST_CHECK(GetLockStats().empty());
+}
+
+BOOST_AUTO_TEST_CASE(csmainwait_by_address)
+{
+    CCriticalSection csTest;
+    CCriticalSection& csAlias = csTest;
+    RegisterCsMainWait(&csTest);
+
+    std::atomic<bool> fHeld(false);
+    std::thread holder([&] {
+        LOCK(csTest);
+        fHeld = true;
+        MilliSleep(50);
+    });
+    while (!fHeld)
+        MilliSleep(1);
+    int64_t nWaitStart = GetThreadCsMainWait();
+    {
+        // the wait counts under another name for the same lock
+        LOCK(csAlias);
+    }
+    holder.join();
+    BOOST_CHECK(GetThreadCsMainWait() > nWaitStart);
+
+    RegisterCsMainWait(NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
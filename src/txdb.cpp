@@ -13,7 +13,11 @@
 #include "ui_interface.h"
 #include "init.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <stdint.h>
+#include <tuple>
 
 #include <boost/thread.hpp>
 
@@ -23,8 +27,14 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
-static const char DB_DOCUMENTINDEX = 'd';
+static const char DB_DOCUMENTINDEX = 'x';
+static const char DB_DOCUMENTINDEX_LEGACY = 'd';
+static const char DB_DOCUMENTHASHINDEX = 'h';
+static const char DB_DOCUMENTCOUNT = 'N';
+static const char DB_DOCUMENTHEIGHTCOUNT = 'D';
+static const char DB_DOCUMENTINDEXBEST = 'I';
 static const char DB_TIMESTAMPINDEX = 's';
+static const char DB_DOCFILTER = 'G';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
 
@@ -308,21 +318,66 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, std::string> >&vect) {
+bool CBlockTreeDB::WriteDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >&vect,
+                                      const std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >&hashVect,
+                                      int nHeight, const CBlockLocator* pBestBlock) {
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CDocumentIndexKey, std::string> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+    if (pBestBlock)
+        batch.Write(DB_DOCUMENTINDEXBEST, *pBestBlock);
+    for (std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         batch.Write(std::make_pair(DB_DOCUMENTINDEX, it->first), it->second);
     }
+    for (std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >::const_iterator it=hashVect.begin(); it!=hashVect.end(); it++) {
+        batch.Write(std::make_pair(DB_DOCUMENTHASHINDEX, it->first), it->second);
+    }
+
+    // the per-height delta replaces a previous one, so reconnecting a block
+    // (e.g. VerifyDB level 4) does not count its documents twice
+    int nOldDelta = 0;
+    Read(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, nHeight), nOldDelta);
+    int nDelta = vect.size();
+    if (nDelta > 0)
+        batch.Write(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, nHeight), nDelta);
+    else
+        batch.Erase(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, nHeight));
+    batch.Write(DB_DOCUMENTCOUNT, ReadDocumentCount() + nDelta - nOldDelta);
     return WriteBatch(batch);
 }
 
-/*
-bool CBlockTreeDB::ReadDocument(const std::string &fileHash, std::string &tx) {
-    return Read(std::make_pair(DB_DOCUMENTINDEX, fileHash), tx);
+bool CBlockTreeDB::EraseDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >&vect,
+                                      const std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >&hashVect,
+                                      int nHeight, const CBlockLocator* pBestBlock) {
+    CDBBatch batch(*this);
+    if (pBestBlock)
+        batch.Write(DB_DOCUMENTINDEXBEST, *pBestBlock);
+    for (std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        batch.Erase(std::make_pair(DB_DOCUMENTINDEX, it->first));
+    }
+    for (std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >::const_iterator it=hashVect.begin(); it!=hashVect.end(); it++) {
+        batch.Erase(std::make_pair(DB_DOCUMENTHASHINDEX, it->first));
+    }
+
+    int nDelta = 0;
+    if (Read(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, nHeight), nDelta)) {
+        batch.Erase(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, nHeight));
+        batch.Write(DB_DOCUMENTCOUNT, ReadDocumentCount() - nDelta);
+    }
+    return WriteBatch(batch);
 }
-*/
 
 int CBlockTreeDB::ReadDocumentCount() {
+    int nTotal = 0;
+    Read(DB_DOCUMENTCOUNT, nTotal);
+    return nTotal;
+}
+
+bool CBlockTreeDB::InitDocumentCount() {
+    if (Exists(DB_DOCUMENTCOUNT))
+        return true;
+
+    // one-time upgrade of an index written before the counter existed
+    LogPrintf("Counting documents in the document index...\n");
+    std::map<int, int> mapHeightCount;
     int nTotal = 0;
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
@@ -332,6 +387,7 @@ int CBlockTreeDB::ReadDocumentCount() {
         boost::this_thread::interruption_point();
         std::pair<char, CDocumentIndexKey> key;
         if (pcursor->GetKey(key) && key.first == DB_DOCUMENTINDEX) {
+            mapHeightCount[key.second.blockHeight]++;
             nTotal++;
             pcursor->Next();
         } 
@@ -340,35 +396,170 @@ int CBlockTreeDB::ReadDocumentCount() {
         }
     }
 
-    return nTotal;
+    CDBBatch batch(*this);
+    for (std::map<int, int>::const_iterator it = mapHeightCount.begin(); it != mapHeightCount.end(); it++) {
+        batch.Write(std::make_pair(DB_DOCUMENTHEIGHTCOUNT, it->first), it->second);
+    }
+    batch.Write(DB_DOCUMENTCOUNT, nTotal);
+    LogPrintf("Counted %d documents in %u blocks\n", nTotal, mapHeightCount.size());
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::WriteDocumentIndexBest(const CBlockLocator &locator) {
+    return Write(DB_DOCUMENTINDEXBEST, locator);
 }
 
-bool CBlockTreeDB::ReadDocumentIndex(std::vector<std::pair<CDocumentIndexKey, std::string> > &documentIndex,
-                                     std::string hashFilter) {
+bool CBlockTreeDB::ReadDocumentIndexBest(CBlockLocator &locator) {
+    return Read(DB_DOCUMENTINDEXBEST, locator);
+}
+
+bool CBlockTreeDB::EraseDocumentIndexBest() {
+    return Erase(DB_DOCUMENTINDEXBEST);
+}
+
+bool CBlockTreeDB::HasDocumentIndexData() {
+    if (Exists(DB_DOCUMENTCOUNT) || Exists(DB_DOCUMENTINDEXBEST))
+        return true;
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    std::string sValue;
-    std::transform(hashFilter.begin(), hashFilter.end(), hashFilter.begin(), ::tolower);
+    for (char chPrefix : {DB_DOCUMENTINDEX, DB_DOCUMENTINDEX_LEGACY, DB_DOCUMENTHASHINDEX, DB_DOCUMENTHEIGHTCOUNT}) {
+        pcursor->Seek(chPrefix);
+        char chKey;
+        if (pcursor->Valid() && pcursor->GetKey(chKey) && chKey == chPrefix)
+            return true;
+    }
+    return false;
+}
 
-    if (hashFilter.empty())
-        pcursor->Seek(DB_DOCUMENTINDEX);
-    else
-        pcursor->Seek(std::make_pair(DB_DOCUMENTINDEX, CDocumentIndexIteratorKey(hashFilter)));
+bool CBlockTreeDB::HasLegacyDocumentIndex() {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(DB_DOCUMENTINDEX_LEGACY);
+    char chKey;
+    return pcursor->Valid() && pcursor->GetKey(chKey) && chKey == DB_DOCUMENTINDEX_LEGACY;
+}
+
+template <typename K>
+static bool EraseKeysWithPrefix(CDBWrapper& db, char chPrefix) {
+    static const size_t nBatchSize = 1 << 20;
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    CDBBatch batch(db);
 
+    pcursor->Seek(chPrefix);
     while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, K> key;
+        if (!pcursor->GetKey(key) || key.first != chPrefix)
+            break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > nBatchSize) {
+            if (!db.WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
+        pcursor->Next();
+    }
+    if (!db.WriteBatch(batch))
+        return false;
+
+    db.CompactRange(chPrefix, (char)(chPrefix + 1));
+    return true;
+}
+
+bool CBlockTreeDB::EraseDocumentIndexData() {
+    // LevelDB has no range delete, the keys are removed in batches without reading their values
+    if (!EraseKeysWithPrefix<CDocumentIndexKey>(*this, DB_DOCUMENTINDEX) ||
+        !EraseKeysWithPrefix<CLegacyDocumentIndexKey>(*this, DB_DOCUMENTINDEX_LEGACY) ||
+        !EraseKeysWithPrefix<CDocumentHashIndexKey>(*this, DB_DOCUMENTHASHINDEX) ||
+        !EraseKeysWithPrefix<int>(*this, DB_DOCUMENTHEIGHTCOUNT))
+        return false;
+
+    CDBBatch batch(*this);
+    batch.Erase(DB_DOCUMENTCOUNT);
+    batch.Erase(DB_DOCUMENTINDEXBEST);
+    return WriteBatch(batch);
+}
+
+// Visit the entries from the cursor position while they match pFilter (all entries if null), false if the visitor stopped
+static bool ReadDocumentIndexEntries(CDBIterator& cursor, const CDocumentIndexIteratorKey* pFilter, const CDocumentIndexKey* pStartAfter,
+                                     boost::function<bool(const CDocumentIndexKey&, const CDocumentIndexValue&)>& visitor, bool& fError) {
+    CDocumentIndexValue value;
+    while (cursor.Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, CDocumentIndexKey> key;
-        if ( (pcursor->GetKey(key) && key.first == DB_DOCUMENTINDEX) && 
-             (hashFilter.empty() || (hashFilter == key.second.fileHash())) )
+        if (!cursor.GetKey(key) || key.first != DB_DOCUMENTINDEX)
+            break;
+        if (pFilter && (key.second.algo != pFilter->algo || key.second.hash != pFilter->hash))
+            break;
+        if (pStartAfter && key.second == *pStartAfter) {
+            cursor.Next();
+            continue;
+        }
+        if (!cursor.GetValue(value)) {
+            fError = true;
+            return error("failed to get document index value");
+        }
+        if (!visitor(key.second, value))
+            return false;
+        cursor.Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::ReadDocumentIndex(boost::function<bool(const CDocumentIndexKey&, const CDocumentIndexValue&)> visitor,
+                                     const std::string& hashFilter, const CDocumentIndexKey* pStartAfter) {
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    bool fError = false;
+
+    if (hashFilter.empty()) {
+        if (pStartAfter)
+            pcursor->Seek(std::make_pair(DB_DOCUMENTINDEX, *pStartAfter));
+        else
+            pcursor->Seek(DB_DOCUMENTINDEX);
+        ReadDocumentIndexEntries(*pcursor, nullptr, pStartAfter, visitor, fError);
+        return !fError;
+    }
+
+    // a hash may be of any algorithm with its length, one seek per candidate in key order
+    std::vector<unsigned char> vchHash = ParseHex(hashFilter);
+    for (int algo = 0; algo < 40; algo++) {
+        if (CDocument::HashHexLength(algo) != (int)hashFilter.size())
+            continue;
+        if (pStartAfter && algo < pStartAfter->algo)
+            continue;
+
+        CDocumentIndexIteratorKey filter(algo, vchHash);
+        if (pStartAfter && algo == pStartAfter->algo)
+            pcursor->Seek(std::make_pair(DB_DOCUMENTINDEX, *pStartAfter));
+        else
+            pcursor->Seek(std::make_pair(DB_DOCUMENTINDEX, filter));
+        if (!ReadDocumentIndexEntries(*pcursor, &filter, pStartAfter, visitor, fError))
+            break;
+    }
+
+    return !fError;
+}
+
+// Collect the entries of one hash, leaves the cursor behind them
+static bool ReadDocumentHashEntries(CDBIterator& cursor, const CDocumentHashIndexIteratorKey& hashKey,
+                                    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > &documentIndex) {
+    CDocumentIndexValue value;
+    cursor.Seek(std::make_pair(DB_DOCUMENTHASHINDEX, hashKey));
+
+    while (cursor.Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CDocumentHashIndexKey> key;
+        if (cursor.GetKey(key) && key.first == DB_DOCUMENTHASHINDEX &&
+            key.second.type == hashKey.type && key.second.algo == hashKey.algo && key.second.hash == hashKey.hash)
         {
-            if (pcursor->GetValue(sValue)) {
-                documentIndex.push_back(std::make_pair(key.second, sValue));
-            } 
+            if (cursor.GetValue(value)) {
+                documentIndex.push_back(std::make_pair(key.second, value));
+            }
             else {
-                return error("failed to get document index value");
+                return error("failed to get document hash index value");
             }
-            pcursor->Next();
-        } 
+            cursor.Next();
+        }
         else {
             break;
         }
@@ -377,6 +568,42 @@ bool CBlockTreeDB::ReadDocumentIndex(std::vector<std::pair<CDocumentIndexKey, st
     return true;
 }
 
+bool CBlockTreeDB::ReadDocumentHashIndex(unsigned char type, unsigned char algo, const std::vector<unsigned char> &hash,
+                                         std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > &documentIndex) {
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    return ReadDocumentHashEntries(*pcursor, CDocumentHashIndexIteratorKey(type, algo, hash), documentIndex);
+}
+
+bool CBlockTreeDB::ReadDocumentHashIndex(const std::vector<CDocumentHashIndexIteratorKey> &keys,
+                                         std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > > &documentIndex) {
+
+    // visit the keys in database order with a single cursor, so each seek lands close to the previous one
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+        return std::tie(keys[a].type, keys[a].algo, keys[a].hash) < std::tie(keys[b].type, keys[b].algo, keys[b].hash);
+    });
+
+    documentIndex.assign(keys.size(), std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >());
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    for (size_t n = 0; n < order.size(); n++) {
+        const CDocumentHashIndexIteratorKey& key = keys[order[n]];
+        if (n > 0) {
+            const CDocumentHashIndexIteratorKey& prev = keys[order[n - 1]];
+            if (key.type == prev.type && key.algo == prev.algo && key.hash == prev.hash) {
+                documentIndex[order[n]] = documentIndex[order[n - 1]];
+                continue;
+            }
+        }
+        if (!ReadDocumentHashEntries(*pcursor, key, documentIndex[order[n]]))
+            return false;
+    }
+
+    return true;
+}
+
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -403,6 +630,19 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
     return true;
 }
 
+bool CBlockTreeDB::WriteDocumentFilter(const uint256 &blockHash, const std::vector<unsigned char> &vFilter, const uint256 &header) {
+    return Write(std::make_pair(DB_DOCFILTER, blockHash), std::make_pair(vFilter, header));
+}
+
+bool CBlockTreeDB::ReadDocumentFilter(const uint256 &blockHash, std::vector<unsigned char> &vFilter, uint256 &header) {
+    std::pair<std::vector<unsigned char>, uint256> value;
+    if (!Read(std::make_pair(DB_DOCFILTER, blockHash), value))
+        return false;
+    vFilter.swap(value.first);
+    header = value.second;
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -428,8 +668,8 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
         if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
             CDiskBlockIndex diskindex;
             if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
+                // Construct block index object, the hash in the key is trusted here (see VerifyBlockIndexHashes)
+                CBlockIndex* pindexNew = insertBlockIndex(key.second);
                 pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
                 pindexNew->nHeight        = diskindex.nHeight;
                 pindexNew->nFile          = diskindex.nFile;
@@ -135,12 +135,35 @@ public:
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
-    bool WriteDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, std::string> >&vect);
+    bool WriteDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >&vect,
+                            const std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >&hashVect,
+                            int nHeight, const CBlockLocator* pBestBlock = nullptr);
+    bool EraseDocumentIndex(const std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >&vect,
+                            const std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >&hashVect,
+                            int nHeight, const CBlockLocator* pBestBlock = nullptr);
     int  ReadDocumentCount();
-    bool ReadDocumentIndex(std::vector<std::pair<CDocumentIndexKey, std::string> > &documentIndex,
-                           std::string hashFilter = "");
+    bool InitDocumentCount();
+    bool WriteDocumentIndexBest(const CBlockLocator &locator);
+    bool ReadDocumentIndexBest(CBlockLocator &locator);
+    bool EraseDocumentIndexBest();
+    bool HasDocumentIndexData();
+    /** Whether the document index holds keys written before DOCUMENT_INDEX_KEY_VERSION */
+    bool HasLegacyDocumentIndex();
+    bool EraseDocumentIndexData();
+    /** Pass the document index entries in key order to visitor until it returns false,
+     *  hashFilter (hex) matches every algorithm of its length */
+    bool ReadDocumentIndex(boost::function<bool(const CDocumentIndexKey&, const CDocumentIndexValue&)> visitor,
+                           const std::string& hashFilter = "", const CDocumentIndexKey* pStartAfter = nullptr);
+    bool ReadDocumentHashIndex(unsigned char type, unsigned char algo, const std::vector<unsigned char> &hash,
+                               std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > &documentIndex);
+    /** Look up many hashes in one pass, documentIndex[i] receives the entries of keys[i] */
+    bool ReadDocumentHashIndex(const std::vector<CDocumentHashIndexIteratorKey> &keys,
+                               std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > > &documentIndex);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
+    /** The encoded document filter of a block and its header, see documentfilter.h */
+    bool WriteDocumentFilter(const uint256 &blockHash, const std::vector<unsigned char> &vFilter, const uint256 &header);
+    bool ReadDocumentFilter(const uint256 &blockHash, std::vector<unsigned char> &vFilter, uint256 &header);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
@@ -647,6 +647,67 @@ bool CTxMemPool::removeSpentIndex(const uint256 txhash)
     return true;
 }
 
+void CTxMemPool::addDocumentIndex(const CTxMemPoolEntry &entry)
+{
+    LOCK(cs);
+
+    const CTransaction& tx = entry.GetTx();
+    uint256 txhash = tx.GetHash();
+    if (mapDocumentInserted.count(txhash))
+        return;
+
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > documentIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentHashIndex;
+    GetDocumentIndexEntries(tx, -1, 0, documentIndex, documentHashIndex);
+    if (documentHashIndex.empty())
+        return;
+
+    std::vector<CMempoolDocumentKey> inserted;
+    for (const auto& item : documentHashIndex) {
+        CMempoolDocumentKey key(item.first.type, item.first.algo, item.first.hash, txhash, item.second.vout);
+        mapDocument.insert(std::make_pair(key, entry.GetTime()));
+        inserted.push_back(key);
+    }
+
+    mapDocumentInserted.insert(std::make_pair(txhash, inserted));
+}
+
+void CTxMemPool::addDocumentIndexes()
+{
+    LOCK(cs);
+    for (const CTxMemPoolEntry& entry : mapTx) {
+        addDocumentIndex(entry);
+    }
+}
+
+bool CTxMemPool::getDocumentIndex(unsigned char type, int algo, const std::vector<unsigned char> &hash,
+                                  std::vector<std::pair<CMempoolDocumentKey, int64_t> > &results)
+{
+    LOCK(cs);
+    mapDocumentIndex::iterator it = mapDocument.lower_bound(CMempoolDocumentKey(type, algo, hash));
+    while (it != mapDocument.end() && it->first.type == type && it->first.algo == algo &&
+           (hash.empty() || it->first.hash == hash)) {
+        results.push_back(*it);
+        it++;
+    }
+    return true;
+}
+
+bool CTxMemPool::removeDocumentIndex(const uint256 txhash)
+{
+    LOCK(cs);
+    mapDocumentIndexInserted::iterator it = mapDocumentInserted.find(txhash);
+
+    if (it != mapDocumentInserted.end()) {
+        for (const CMempoolDocumentKey& key : it->second) {
+            mapDocument.erase(key);
+        }
+        mapDocumentInserted.erase(it);
+    }
+
+    return true;
+}
+
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 {
     NotifyEntryRemoved(it->GetSharedTx(), reason);
@@ -717,6 +778,7 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     minerPolicyEstimator->removeTx(hash);
     removeAddressIndex(hash);
     removeSpentIndex(hash);
+    removeDocumentIndex(hash);
 }
 
 // Calculates descendants of entry that are not already in setDescendants, and adds to
@@ -1013,6 +1075,8 @@ void CTxMemPool::_clear()
     mapNextTx.clear();
     mapProTxAddresses.clear();
     mapProTxPubKeyIDs.clear();
+    mapDocument.clear();
+    mapDocumentInserted.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
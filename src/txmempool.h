@@ -538,6 +538,13 @@ private:
     typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
     mapSpentIndexInserted mapSpentInserted;
 
+    // value is the time the document entered the mempool
+    typedef std::map<CMempoolDocumentKey, int64_t, CMempoolDocumentKeyCompare> mapDocumentIndex;
+    mapDocumentIndex mapDocument;
+
+    typedef std::map<uint256, std::vector<CMempoolDocumentKey> > mapDocumentIndexInserted;
+    mapDocumentIndexInserted mapDocumentInserted;
+
     std::multimap<uint256, uint256> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
     std::map<CService, uint256> mapProTxAddresses;
     std::map<CKeyID, uint256> mapProTxPubKeyIDs;
@@ -583,6 +590,14 @@ public:
     bool getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
     bool removeSpentIndex(const uint256 txhash);
 
+    void addDocumentIndex(const CTxMemPoolEntry &entry);
+    /** Index the documents of the transactions already in the pool, when the document index gets enabled */
+    void addDocumentIndexes();
+    /** Unconfirmed documents with this hash, all documents of the type and algorithm for an empty hash */
+    bool getDocumentIndex(unsigned char type, int algo, const std::vector<unsigned char> &hash,
+                          std::vector<std::pair<CMempoolDocumentKey, int64_t> > &results);
+    bool removeDocumentIndex(const uint256 txhash);
+
     void removeRecursive(const CTransaction &tx, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
     void removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMemPoolHeight, int flags);
     void removeConflicts(const CTransaction &tx);
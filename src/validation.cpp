@@ -16,7 +16,9 @@
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
+#include "documentfilter.h"
 #include "hash.h"
+#include "headerhash.h"
 #include "init.h"
 #include "policy/policy.h"
 #include "pow.h"
@@ -79,7 +81,8 @@ std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = true;
 bool fAddressIndex = false;
-bool fDocumentIndex = false;
+std::atomic<bool> fDocumentIndex{false};
+bool fDocFilterIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fHavePruned = false;
@@ -93,7 +96,6 @@ size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
 bool fAlerts = DEFAULT_ALERTS;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
-int fDocumentCount = -1;
 
 std::atomic<bool> fDIP0001ActiveAtTip{false};
 std::atomic<bool> fDIP0003ActiveAtTip{false};
@@ -915,6 +917,11 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
             pool.addSpentIndex(entry, view);
         }
 
+        // Add memory document index
+        if (fDocumentIndex) {
+            pool.addDocumentIndex(entry);
+        }
+
         // trim mempool and check if tx was trimmed
         if (!fOverrideMempoolLimit) {
             LimitMempoolSize(pool, GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
@@ -1005,19 +1012,115 @@ bool GetDocumentCount(int &totalCount) {
     if (!fDocumentIndex)
         return error("document index not enabled");
 
-    if (fDocumentCount < 0)
-        fDocumentCount = pblocktree->ReadDocumentCount();
+    totalCount = pblocktree->ReadDocumentCount();
+    return true;
+}
+
+bool GetDocumentList(boost::function<bool(const CDocumentIndexKey&, const CDocumentIndexValue&)> visitor,
+                     const std::string& hashFilter, const CDocumentIndexKey* pStartAfter) {
+    if (!fDocumentIndex)
+        return error("document index not enabled");
+
+    return pblocktree->ReadDocumentIndex(visitor, hashFilter, pStartAfter);
+}
+
+static void AddDocumentHashIndexKey(unsigned char type, const CDocumentHashRef& dochash, int nHeight, int nTxIndex, const CDocumentIndexValue& value,
+                                    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& vKeys)
+{
+    if (dochash.IsNull())
+        return;
+
+    vKeys.push_back(std::make_pair(CDocumentHashIndexKey(type, dochash, nHeight, nTxIndex, value.vout), value));
+}
+
+void GetDocumentHashIndexKeys(const CDocumentRef& document, int nHeight, int nTxIndex, const CDocumentIndexValue& value,
+                              std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& vKeys)
+{
+    if (document.guid.algo == 0)
+        AddDocumentHashIndexKey(DOCUMENT_HASH_GUID, document.guid, nHeight, nTxIndex, value, vKeys);
+    // both the MD5 index hash and the full-width file hash are searchable by file hash
+    AddDocumentHashIndexKey(DOCUMENT_HASH_FILE, document.indexhash, nHeight, nTxIndex, value, vKeys);
+    if (document.indexhash.IsNull() || document.filehash.algo != document.indexhash.algo ||
+        !std::equal(document.filehash.begin(), document.filehash.end(), document.indexhash.begin()))
+        AddDocumentHashIndexKey(DOCUMENT_HASH_FILE, document.filehash, nHeight, nTxIndex, value, vKeys);
+    AddDocumentHashIndexKey(DOCUMENT_HASH_OWNER, document.ownerhash, nHeight, nTxIndex, value, vKeys);
+    AddDocumentHashIndexKey(DOCUMENT_HASH_BATCH, document.merkleroot, nHeight, nTxIndex, value, vKeys);
+}
+
+void GetDocumentIndexEntries(const CTransaction& tx, int nHeight, int nTxIndex,
+                             std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >& documentIndex,
+                             std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& documentHashIndex)
+{
+    if (tx.IsCoinBase())
+        return;
+
+    const uint256& txhash = tx.GetHash();
+    for (unsigned int n = 0; n < tx.vout.size(); n++) {
+        // parsed in place, most outputs are rejected after the first script byte
+        CDocumentRef document;
+        if (tx.vout[n].GetDocumentRef(document)) {
+            // one entry per document, by its MD5 index hash or else its full-width file hash;
+            // batch anchors (version 3) carry no file hash of their own, only the hash index sees them
+            const CDocumentHashRef& filehash = document.indexhash.IsNull() ? document.filehash : document.indexhash;
+            if (!filehash.IsNull())
+                documentIndex.push_back(std::make_pair(CDocumentIndexKey(filehash, nHeight, nTxIndex, n), CDocumentIndexValue(txhash, n)));
+            GetDocumentHashIndexKeys(document, nHeight, nTxIndex, CDocumentIndexValue(txhash, n), documentHashIndex);
+        }
+    }
+}
+
+bool GetDocumentsByHash(unsigned char type, int algo, const std::string& hash,
+                        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > &documentList) {
+    if (!fDocumentIndex)
+        return error("document index not enabled");
+
+    if (algo < 0 || hash.size() != (size_t)CDocument::HashHexLength(algo) || !IsHex(hash))
+        return false;
+
+    std::vector<unsigned char> vchHash = ParseHex(hash);
+    if (!pblocktree->ReadDocumentHashIndex(type, algo, vchHash, documentList))
+        return false;
 
-    totalCount = fDocumentCount;
+    // unconfirmed documents follow with height -1
+    std::vector<std::pair<CMempoolDocumentKey, int64_t> > mempoolDocuments;
+    mempool.getDocumentIndex(type, algo, vchHash, mempoolDocuments);
+    for (const auto& item : mempoolDocuments)
+        documentList.push_back(std::make_pair(CDocumentHashIndexKey(type, algo, vchHash, -1, 0, item.first.vout), CDocumentIndexValue(item.first.txhash, item.first.vout)));
     return true;
 }
 
-bool GetDocumentList(std::vector<std::pair<CDocumentIndexKey, std::string> > &documentList,
-                     const std::string& hashFilter) {
+bool GetDocumentsByHashes(const std::vector<CDocumentHashIndexIteratorKey>& keys,
+                          std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > >& documentLists) {
     if (!fDocumentIndex)
         return error("document index not enabled");
 
-    return pblocktree->ReadDocumentIndex(documentList, hashFilter);
+    if (!pblocktree->ReadDocumentHashIndex(keys, documentLists))
+        return false;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        std::vector<std::pair<CMempoolDocumentKey, int64_t> > mempoolDocuments;
+        mempool.getDocumentIndex(keys[i].type, keys[i].algo, keys[i].hash, mempoolDocuments);
+        for (const auto& item : mempoolDocuments)
+            documentLists[i].push_back(std::make_pair(CDocumentHashIndexKey(keys[i].type, keys[i].algo, keys[i].hash, -1, 0, item.first.vout), CDocumentIndexValue(item.first.txhash, item.first.vout)));
+    }
+    return true;
+}
+
+bool GetDocumentFilter(const CBlockIndex* pindex, CDocumentFilter& filter, uint256& header)
+{
+    if (!fDocFilterIndex)
+        return false;
+
+    std::vector<unsigned char> vFilter;
+    if (!pblocktree->ReadDocumentFilter(pindex->GetBlockHash(), vFilter, header))
+        return false;
+
+    try {
+        filter = CDocumentFilter(pindex->GetBlockHash(), std::move(vFilter));
+    } catch (const std::exception& e) {
+        return error("%s: invalid document filter for block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+    }
+    return true;
 }
 
 /** Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock */
@@ -1627,7 +1730,7 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state. */
-static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view)
+static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck = false)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
 
@@ -1660,6 +1763,8 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > documentIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentHashIndex;
 
     if (!UndoSpecialTxsInBlock(block, pindex)) {
         return DISCONNECT_FAILED;
@@ -1671,6 +1776,11 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
+        if (fDocumentIndex) {
+            // the index keys only depend on the block, no extra undo data is needed
+            GetDocumentIndexEntries(tx, pindex->nHeight, i, documentIndex, documentHashIndex);
+        }
+
         if (fAddressIndex) {
 
             for (unsigned int k = tx.vout.size(); k-- > 0;) {
@@ -1790,6 +1900,14 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         }
     }
 
+    // VerifyDB only disconnects in memory, the document index stays as is
+    if (fDocumentIndex && !fJustCheck) {
+        if (!pblocktree->EraseDocumentIndex(documentIndex, documentHashIndex, pindex->nHeight)) {
+            AbortNode(state, "Failed to delete document index");
+            return DISCONNECT_FAILED;
+        }
+    }
+
     // make sure the flag is reset in case of a chain reorg
     // (we reused the DIP3 deployment)
     instantsend.isAutoLockBip9Active =
@@ -1929,6 +2047,20 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 
+/** Store the document filter of a connected block, chained to the filter header of its parent */
+static bool WriteDocumentFilterIndex(const CBlock& block, const CBlockIndex* pindex)
+{
+    uint256 prevHeader;
+    if (pindex->pprev) {
+        std::vector<unsigned char> vPrevFilter;
+        if (!pblocktree->ReadDocumentFilter(pindex->pprev->GetBlockHash(), vPrevFilter, prevHeader))
+            return error("%s: no document filter for the parent of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDocumentFilter filter(pindex->GetBlockHash(), GetDocumentFilterElements(block));
+    return pblocktree->WriteDocumentFilter(pindex->GetBlockHash(), filter.GetEncoded(), filter.ComputeHeader(prevHeader));
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
@@ -1960,8 +2092,11 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     // Special case for the genesis block, skipping connection of its transactions
     // (its coinbase is unspendable)
     if (block.GetHash() == chainparams.GetConsensus().hashGenesisBlock) {
-        if (!fJustCheck)
+        if (!fJustCheck) {
+            if (fDocFilterIndex && !WriteDocumentFilterIndex(block, pindex))
+                return AbortNode(state, "Failed to write document filter index");
             view.SetBestBlock(pindex->GetBlockHash());
+        }
         return true;
     }
 
@@ -2087,7 +2222,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-    std::vector<std::pair<CDocumentIndexKey, std::string> > documentIndex;
+    std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> > documentIndex;
+    std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > documentHashIndex;
 
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
 
@@ -2162,19 +2298,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             }
 
             if (fDocumentIndex)
-            {
-                for (size_t j = 0; j < tx.vout.size(); j++) {
-                    const CTxOut output = tx.vout[j];
-                    std::string docGuid;
-                    std::string docIndexhash;
-                    std::string docFilehash;
-                    std::string docAttrhash;
-                    if (output.GetDocument(docGuid, docIndexhash, docFilehash, docAttrhash)) {
-                        fDocumentCount = -1;
-                        documentIndex.push_back(std::make_pair(CDocumentIndexKey(docIndexhash, pindex->nHeight, i), txhash.ToString()));
-                    }
-                }
-            }
+                GetDocumentIndexEntries(tx, pindex->nHeight, i, documentIndex, documentHashIndex);
 
             if (fStrictPayToScriptHash)
             {
@@ -2339,8 +2463,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         }
     }
 
-    if (fDocumentIndex && !documentIndex.empty()) {
-        if (!pblocktree->WriteDocumentIndex(documentIndex)) {
+    // a block may carry batch anchors only, which are in the hash index alone
+    if (fDocumentIndex && (!documentIndex.empty() || !documentHashIndex.empty())) {
+        if (!pblocktree->WriteDocumentIndex(documentIndex, documentHashIndex, pindex->nHeight)) {
             return AbortNode(state, "Failed to write document index");
         }
     }
@@ -2353,6 +2478,10 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
             return AbortNode(state, "Failed to write timestamp index");
 
+    if (fDocFilterIndex)
+        if (!WriteDocumentFilterIndex(block, pindex))
+            return AbortNode(state, "Failed to write document filter index");
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -3107,10 +3236,9 @@ bool ResetBlockFailureFlags(CBlockIndex *pindex) {
     return true;
 }
 
-CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
+static CBlockIndex* AddToBlockIndex(const CBlockHeader& block, const uint256& hash)
 {
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator it = mapBlockIndex.find(hash);
     if (it != mapBlockIndex.end())
         return it->second;
@@ -3142,6 +3270,11 @@ CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
     return pindexNew;
 }
 
+CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
+{
+    return AddToBlockIndex(block, block.GetHash());
+}
+
 /** Mark a block as having its data received and checked (up to BLOCK_VALID_TRANSACTIONS). */
 bool ReceivedBlockTransactions(const CBlock &block, CValidationState& state, CBlockIndex *pindexNew, const CDiskBlockPos& pos)
 {
@@ -3276,16 +3409,16 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
     return true;
 }
 
-bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+static bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(hash, block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     // Check DevNet
     if (!consensusParams.hashDevnetGenesisBlock.IsNull() &&
             block.hashPrevBlock == consensusParams.hashGenesisBlock &&
-            block.GetHash() != consensusParams.hashDevnetGenesisBlock) {
+            hash != consensusParams.hashDevnetGenesisBlock) {
         return state.DoS(100, error("CheckBlockHeader(): wrong devnet genesis"),
                          REJECT_INVALID, "devnet-genesis");
     }
@@ -3293,6 +3426,11 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const
     return true;
 }
 
+bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+{
+    return CheckBlockHeader(block, block.GetHash(), state, consensusParams, fCheckPOW);
+}
+
 bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot)
 {
     // These are checks that are independent of context.
@@ -3469,11 +3607,10 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = NULL;
 
@@ -3490,7 +3627,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, hash, state, chainparams.GetConsensus(), true))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3510,7 +3647,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return error("%s: Consensus::ContextualCheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
     }
     if (pindex == NULL)
-        pindex = AddToBlockIndex(block);
+        pindex = AddToBlockIndex(block, hash);
 
     if (ppindex)
         *ppindex = pindex;
@@ -3524,13 +3661,14 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
 {
+    assert(headers.size() == hashes.size());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
             CBlockIndex *pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!AcceptBlockHeader(headers[i], hashes[i], state, chainparams, &pindex)) {
                 return false;
             }
             if (ppindex) {
@@ -3542,6 +3680,12 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
     return true;
 }
 
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+{
+    // hash outside of cs_main, this is the expensive part
+    return ProcessNewBlockHeaders(headers, HashBlockHeaders(headers), state, chainparams, ppindex);
+}
+
 /** Store block on disk. If dbp is non-NULL, the file is known to already reside on disk */
 static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock)
 {
@@ -3553,7 +3697,7 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
     CBlockIndex *pindexDummy = NULL;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, block.GetHash(), state, chainparams, &pindex))
         return false;
 
     // Try to process all requested blocks that we don't have, but only
@@ -3885,6 +4029,45 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
     return pindexNew;
 }
 
+/**
+ * The block index stores each header together with its yescrypt hash, which is trusted
+ * when loading. Only re-hash the entries within -blockindextrustdepth of the best known
+ * height, or all of them if -verifyblockindex or -checkblockindex is set.
+ */
+static bool VerifyBlockIndexHashes(const std::vector<std::pair<int, CBlockIndex*> >& vSortedByHeight)
+{
+    if (vSortedByHeight.empty())
+        return true;
+
+    bool fVerifyAll = GetBoolArg("-verifyblockindex", DEFAULT_VERIFYBLOCKINDEX) || fCheckBlockIndex;
+    int nTrustDepth = GetArg("-blockindextrustdepth", DEFAULT_BLOCKINDEX_TRUST_DEPTH);
+    int nMinHeight = fVerifyAll ? 0 : vSortedByHeight.back().first - nTrustDepth + 1;
+    if (!fVerifyAll && nTrustDepth <= 0)
+        return true;
+
+    int64_t nStart = GetTimeMillis();
+    unsigned int nChecked = 0;
+    auto it = vSortedByHeight.rbegin();
+    while (it != vSortedByHeight.rend() && it->first >= nMinHeight) {
+        boost::this_thread::interruption_point();
+        // hash in chunks on the header hashing pool
+        std::vector<const CBlockIndex*> vIndex;
+        std::vector<CBlockHeader> vHeaders;
+        for (; it != vSortedByHeight.rend() && it->first >= nMinHeight && vHeaders.size() < MAX_HEADERS_RESULTS; ++it) {
+            vIndex.push_back(it->second);
+            vHeaders.push_back(it->second->GetBlockHeader());
+        }
+        std::vector<uint256> vHashes = HashBlockHeaders(vHeaders);
+        for (size_t i = 0; i < vIndex.size(); i++) {
+            if (vHashes[i] != vIndex[i]->GetBlockHash())
+                return error("%s: block index entry has a wrong hash: %s", __func__, vIndex[i]->ToString());
+        }
+        nChecked += vIndex.size();
+    }
+    LogPrintf("%s: verified %u block index hashes in %dms\n", __func__, nChecked, GetTimeMillis() - nStart);
+    return true;
+}
+
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
     if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
@@ -3901,6 +4084,8 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
         vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
     }
     sort(vSortedByHeight.begin(), vSortedByHeight.end());
+    if (!VerifyBlockIndexHashes(vSortedByHeight))
+        return false;
     BOOST_FOREACH(const PAIRTYPE(int, CBlockIndex*)& item, vSortedByHeight)
     {
         CBlockIndex* pindex = item.second;
@@ -3984,8 +4169,19 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
     // Check whether we have an document index
-    pblocktree->ReadFlag("documentindex", fDocumentIndex);
+    bool fDocumentIndexFlag = false;
+    pblocktree->ReadFlag("documentindex", fDocumentIndexFlag);
+    fDocumentIndex = fDocumentIndexFlag;
+    if (fDocumentIndex && pblocktree->HasLegacyDocumentIndex()) {
+        // the old keys miss documents without an MD5 hash or with a hash repeated in one transaction,
+        // StartDocumentIndexer rebuilds the index in the background
+        LogPrintf("%s: document index uses an old key format and will be rebuilt\n", __func__);
+        pblocktree->WriteFlag("documentindex", false);
+        fDocumentIndex = false;
+    }
     LogPrintf("%s: document index %s\n", __func__, fDocumentIndex ? "enabled" : "disabled");
+    if (fDocumentIndex && !pblocktree->InitDocumentCount())
+        return error("%s: failed to initialize the document count", __func__);
 
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
@@ -3995,6 +4191,10 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     pblocktree->ReadFlag("spentindex", fSpentIndex);
     LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
 
+    // Check whether we have a document filter index
+    pblocktree->ReadFlag("docfilterindex", fDocFilterIndex);
+    LogPrintf("%s: document filter index %s\n", __func__, fDocFilterIndex ? "enabled" : "disabled");
+
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     if (it == mapBlockIndex.end())
@@ -4080,7 +4280,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         }
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
         if (nCheckLevel >= 3 && pindex == pindexState && (coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) <= nCoinCacheUsage) {
-            DisconnectResult res = DisconnectBlock(block, state, pindex, coins);
+            DisconnectResult res = DisconnectBlock(block, state, pindex, coins, true);
             if (res == DISCONNECT_FAILED) {
                 return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             }
@@ -4198,6 +4398,10 @@ bool InitBlockIndex(const CChainParams& chainparams)
     fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
     pblocktree->WriteFlag("spentindex", fSpentIndex);
 
+    // Use the provided setting for -docfilterindex in the new database
+    fDocFilterIndex = GetBoolArg("-docfilterindex", DEFAULT_DOCFILTERINDEX);
+    pblocktree->WriteFlag("docfilterindex", fDocFilterIndex);
+
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
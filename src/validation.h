@@ -32,12 +32,14 @@
 
 #include <atomic>
 
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/filesystem/path.hpp>
 
 class CBlockIndex;
 class CBlockTreeDB;
 class CBloomFilter;
+class CDocumentFilter;
 class CChainParams;
 class CCoinsViewDB;
 class CInv;
@@ -139,6 +141,7 @@ static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_DOCUMENTINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
+static const bool DEFAULT_DOCFILTERINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 
@@ -169,6 +172,10 @@ extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+/** Document index complete and maintained by ConnectBlock (see documentindexer.h) */
+extern std::atomic<bool> fDocumentIndex;
+/** A document filter and its header are stored for every connected block (see documentfilter.h) */
+extern bool fDocFilterIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern unsigned int nBytesPerSigOp;
@@ -211,6 +218,9 @@ static const unsigned int MIN_BLOCKS_TO_KEEP = 288;
 
 static const signed int DEFAULT_CHECKBLOCKS = 6;
 static const unsigned int DEFAULT_CHECKLEVEL = 3;
+/** Number of most recent block index entries whose stored hash is recomputed at startup */
+static const int DEFAULT_BLOCKINDEX_TRUST_DEPTH = 6;
+static const bool DEFAULT_VERIFYBLOCKINDEX = false;
 
 // Require that user allocate at least 945MB for block & undo files (blk???.dat and rev???.dat)
 // At 2MB per block, 288 blocks = 576MB.
@@ -254,6 +264,8 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
  */
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
+/** As above, with the header hashes already computed (see HashBlockHeaders) */
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, const std::vector<uint256>& hashes, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
@@ -479,8 +491,23 @@ bool GetAddressIndex(uint160 addressHash, int type,
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 bool GetDocumentCount(int &totalCount);
-bool GetDocumentList(std::vector<std::pair<CDocumentIndexKey, std::string> > &documentList,
-                     const std::string& hashFilter = "");
+bool GetDocumentList(boost::function<bool(const CDocumentIndexKey&, const CDocumentIndexValue&)> visitor,
+                     const std::string& hashFilter = "", const CDocumentIndexKey* pStartAfter = nullptr);
+/** Collect the document index entries of a transaction at the given block position */
+void GetDocumentIndexEntries(const CTransaction& tx, int nHeight, int nTxIndex,
+                             std::vector<std::pair<CDocumentIndexKey, CDocumentIndexValue> >& documentIndex,
+                             std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& documentHashIndex);
+/** Collect the secondary index keys (GUID, file hashes, owner hash) of a document */
+void GetDocumentHashIndexKeys(const CDocumentRef& document, int nHeight, int nTxIndex, const CDocumentIndexValue& value,
+                              std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> >& vKeys);
+/** Documents with this hash, confirmed ones first, unconfirmed ones from the mempool with height -1 */
+bool GetDocumentsByHash(unsigned char type, int algo, const std::string& hash,
+                        std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > &documentList);
+/** Bulk variant of GetDocumentsByHash, documentLists[i] receives the documents of keys[i] */
+bool GetDocumentsByHashes(const std::vector<CDocumentHashIndexIteratorKey>& keys,
+                          std::vector<std::vector<std::pair<CDocumentHashIndexKey, CDocumentIndexValue> > >& documentLists);
+/** The document filter of a block and its filter header, false if the block has none */
+bool GetDocumentFilter(const CBlockIndex* pindex, CDocumentFilter& filter, uint256& header);
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
@@ -13,7 +13,9 @@
 #include "init.h"
 #include "instantx.h"
 #include "net.h"
+#include "primitives/document.h"
 #include "rpc/server.h"
+#include "script/standard.h"
 #include "timedata.h"
 #include "util.h"
 #include "utilmoneystr.h"
@@ -1130,6 +1132,82 @@ UniValue sendmany(const JSONRPCRequest& request)
     return wtx.GetHash().GetHex();
 }
 
+/** Maximum number of documents stored in one storedocuments call */
+static const unsigned int MAX_STOREDOCUMENTS = 10000;
+
+UniValue storedocuments(const JSONRPCRequest& request)
+{
+    if (!EnsureWalletIsAvailable(request.fHelp))
+        return NullUniValue;
+
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "storedocuments [\"payload\",...]\n"
+            "\nStore many documents in the blockchain with one call, one transaction per document."
+            + HelpRequiringPassphrase() + "\n"
+            "Coins are selected once. Every confirmed coin pays for a chain of up to -limitancestorcount\n"
+            "documents through its change, so large batches need as many confirmed coins.\n"
+            "\nArguments:\n"
+            "1. \"payloads\"    (array, required) at most " + std::to_string(MAX_STOREDOCUMENTS) + " hex encoded DM$ document payloads\n"
+            "    [\n"
+            "      \"payload\"  (string) the document revision data starting with 444D24\n"
+            "      ,...\n"
+            "    ]\n"
+            "\nResult:\n"
+            "[                (array of string) the transaction ids in the order of the payloads\n"
+            "  \"txid\"\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("storedocuments", "'[\"444D2400020002F0000F343B0931126A20F133D67C2B018A3B\"]'")
+            + HelpExampleRpc("storedocuments", "[\"444D2400020002F0000F343B0931126A20F133D67C2B018A3B\"]")
+        );
+
+    const UniValue& payloads = request.params[0].get_array();
+    if (payloads.empty())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No documents given");
+    if (payloads.size() > MAX_STOREDOCUMENTS)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("At most %u documents per call", MAX_STOREDOCUMENTS));
+
+    // validate all payloads before anything is sent
+    std::vector<std::vector<unsigned char> > vPayloads;
+    vPayloads.reserve(payloads.size());
+    for (size_t i = 0; i < payloads.size(); i++) {
+        std::vector<unsigned char> payload = ParseHexV(payloads[i], strprintf("payloads[%u]", i));
+        CDocumentRef document;
+        if (!document.Parse(payload.data(), payload.data() + payload.size()))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("payloads[%u] is not a valid document", i));
+        // OP_RETURN and the push opcodes
+        if (!fAcceptDatacarrier || payload.size() + 3 > nMaxDatacarrierBytes)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("payloads[%u] exceeds the data carrier size", i));
+        vPayloads.push_back(payload);
+    }
+
+    {
+        LOCK2(cs_main, pwalletMain->cs_wallet);
+
+        if (pwalletMain->GetBroadcastTransactions() && !g_connman)
+            throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+
+        EnsureWalletIsUnlocked();
+    }
+
+    // StoreDocuments locks per document
+    std::vector<uint256> vTxid;
+    std::string strFailReason;
+    bool fInsufficientFunds;
+    if (!pwalletMain->StoreDocuments(vPayloads, vTxid, g_connman.get(), strFailReason, fInsufficientFunds)) {
+        if (vTxid.empty())
+            throw JSONRPCError(fInsufficientFunds ? RPC_WALLET_INSUFFICIENT_FUNDS : RPC_WALLET_ERROR, strFailReason);
+        throw JSONRPCError(RPC_WALLET_ERROR, strprintf("%s, last stored transaction %s", strFailReason, vTxid.back().GetHex()));
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const uint256& txid : vTxid)
+        result.push_back(txid.GetHex());
+    return result;
+}
+
 // Defined in rpc/misc.cpp
 extern CScript _createmultisig_redeemScript(const UniValue& params);
 
@@ -2976,6 +3054,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "sendfrom",                 &sendfrom,                 false,  {"fromaccount","toaddress","amount","minconf","addlocked","comment","comment_to"} },
     { "wallet",             "sendmany",                 &sendmany,                 false,  {"fromaccount","amounts","minconf","addlocked","comment","subtractfeefrom"} },
     { "wallet",             "sendtoaddress",            &sendtoaddress,            false,  {"address","amount","comment","comment_to","subtractfeefromamount"} },
+    { "wallet",             "storedocuments",           &storedocuments,           false,  {"payloads"} },
     { "wallet",             "setaccount",               &setaccount,               true,   {"address","account"} },
     { "wallet",             "settxfee",                 &settxfee,                 true,   {"amount"} },
     { "wallet",             "setprivatesendrounds",     &setprivatesendrounds,     true,   {"rounds"} },
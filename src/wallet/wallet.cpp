@@ -3892,6 +3892,151 @@ bool CWallet::CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey, CCon
     return true;
 }
 
+/**
+ * Build and sign a document transaction spending a single coin, with the remainder going back
+ * to scriptChange. The change is dropped to the fee when it would be dust.
+ * @return false with fInsufficientFunds set if the coin cannot pay the fee
+ */
+static bool CreateDocumentTransaction(const CKeyStore& keystore, const COutPoint& outpoint, const CTxOut& txoutIn, const std::vector<unsigned char>& payload,
+                                      const CScript& scriptChange, CMutableTransaction& txNew, int& nChangePosRet, bool& fInsufficientFunds, std::string& strFailReason)
+{
+    fInsufficientFunds = false;
+    txNew = CMutableTransaction();
+    txNew.nLockTime = chainActive.Height();
+    // the sequence number is set to max()-1 so that the nLockTime set above actually works
+    txNew.vin.push_back(CTxIn(outpoint, CScript(), std::numeric_limits<unsigned int>::max() - 1));
+    txNew.vout.push_back(CTxOut(0, CScript() << OP_RETURN << payload));
+    txNew.vout.push_back(CTxOut(txoutIn.nValue, scriptChange));
+    nChangePosRet = 1;
+
+    // dummy signature for the fee calculation
+    if (!ProduceSignature(DummySignatureCreator(&keystore), txoutIn.scriptPubKey, txNew.vin[0].scriptSig)) {
+        strFailReason = _("Signing transaction failed");
+        return false;
+    }
+    unsigned int nBytes = ::GetSerializeSize(txNew, SER_NETWORK, PROTOCOL_VERSION);
+    txNew.vin[0].scriptSig = CScript();
+
+    CAmount nFee = CWallet::GetMinimumFee(nBytes, nTxConfirmTarget, mempool);
+    if (txoutIn.nValue < nFee) {
+        fInsufficientFunds = true;
+        strFailReason = _("Insufficient funds");
+        return false;
+    }
+    txNew.vout[1].nValue -= nFee;
+    if (txNew.vout[1].IsDust(dustRelayFee)) {
+        txNew.vout.pop_back();
+        nChangePosRet = -1;
+    }
+
+    CTransaction txNewConst(txNew);
+    if (!ProduceSignature(TransactionSignatureCreator(&keystore, &txNewConst, 0, SIGHASH_ALL), txoutIn.scriptPubKey, txNew.vin[0].scriptSig)) {
+        strFailReason = _("Signing transaction failed");
+        return false;
+    }
+    return true;
+}
+
+bool CWallet::StoreDocuments(const std::vector<std::vector<unsigned char> >& vPayloads, std::vector<uint256>& vTxidRet, CConnman* connman,
+                             std::string& strFailReason, bool& fInsufficientFundsRet)
+{
+    vTxidRet.clear();
+    fInsufficientFundsRet = false;
+
+    // an unconfirmed chain counts against the ancestor limit of its last and the descendant limit of its first transaction
+    size_t nMaxChainLength = std::min(GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT), GetArg("-limitdescendantcount", DEFAULT_DESCENDANT_LIMIT));
+    if (!bSpendZeroConfChange)
+        nMaxChainLength = 1;
+
+    struct DocumentChain
+    {
+        COutPoint outpoint;  // next coin to spend
+        CTxOut txout;
+        size_t nLength;      // documents in the chain
+    };
+    std::vector<DocumentChain> vChains;
+
+    // all change goes to one key
+    CReserveKey reservekey(this);
+    CScript scriptChange;
+    {
+        LOCK2(cs_main, cs_wallet);
+        std::vector<COutput> vCoins;
+        AvailableCoins(vCoins, true);
+        for (const COutput& out : vCoins) {
+            if (out.fSpendable && out.nDepth > 0)
+                vChains.push_back(DocumentChain{COutPoint(out.tx->GetHash(), out.i), out.tx->tx->vout[out.i], 0});
+        }
+
+        CPubKey vchPubKey;
+        if (!reservekey.GetReservedKey(vchPubKey, true)) {
+            strFailReason = _("Keypool ran out, please call keypoolrefill first");
+            return false;
+        }
+        scriptChange = GetScriptForDestination(vchPubKey.GetID());
+    }
+
+    size_t nChain = 0;
+    for (const std::vector<unsigned char>& payload : vPayloads) {
+        // the locks are taken per document, so a large batch does not stall the node
+        LOCK2(cs_main, cs_wallet);
+        bool fStored = false;
+        while (!fStored && !vChains.empty()) {
+            // round robin keeps the chains short
+            nChain %= vChains.size();
+            DocumentChain& chain = vChains[nChain];
+            // the coin may have been spent by another wallet call in the meantime
+            if (chain.nLength >= nMaxChainLength || IsSpent(chain.outpoint.hash, chain.outpoint.n)) {
+                vChains.erase(vChains.begin() + nChain);
+                continue;
+            }
+
+            CMutableTransaction txNew;
+            int nChangePos;
+            bool fInsufficientFunds;
+            if (!CreateDocumentTransaction(*this, chain.outpoint, chain.txout, payload, scriptChange, txNew, nChangePos, fInsufficientFunds, strFailReason)) {
+                if (!fInsufficientFunds)
+                    return false;
+                // this coin cannot pay for another document
+                vChains.erase(vChains.begin() + nChain);
+                continue;
+            }
+
+            CWalletTx wtx(this, MakeTransactionRef(std::move(txNew)));
+            wtx.fTimeReceivedIsTxTime = true;
+            wtx.fFromMe = true;
+            CValidationState state;
+            if (!CommitTransaction(wtx, reservekey, connman, state)) {
+                strFailReason = strprintf("Transaction commit failed: %s", state.GetRejectReason());
+                return false;
+            }
+            vTxidRet.push_back(wtx.GetHash());
+            if (!state.IsValid()) {
+                // kept by the wallet for rebroadcast, but its change cannot be spent now
+                strFailReason = strprintf("Transaction not accepted to mempool: %s", state.GetRejectReason());
+                return false;
+            }
+
+            if (nChangePos < 0) {
+                vChains.erase(vChains.begin() + nChain);
+            } else {
+                chain.outpoint = COutPoint(wtx.GetHash(), nChangePos);
+                chain.txout = wtx.tx->vout[nChangePos];
+                chain.nLength++;
+                nChain++;
+            }
+            fStored = true;
+        }
+
+        if (!fStored) {
+            fInsufficientFundsRet = true;
+            strFailReason = strprintf(_("Insufficient confirmed coins, %u of %u documents stored"), vTxidRet.size(), vPayloads.size());
+            return false;
+        }
+    }
+    return true;
+}
+
 void CWallet::ListAccountCreditDebit(const std::string& strAccount, std::list<CAccountingEntry>& entries) {
     CWalletDB walletdb(strWalletFile);
     return walletdb.ListAccountCreditDebit(strAccount, entries);
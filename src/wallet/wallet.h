@@ -941,6 +941,16 @@ public:
                            std::string& strFailReason, const CCoinControl *coinControl = NULL, bool sign = true, AvailableCoinsType nCoinType=ALL_COINS, bool fUseInstantSend=false, int nExtraPayloadSize = 0);
     bool CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey, CConnman* connman, CValidationState& state, const std::string& strCommand="tx");
 
+    /**
+     * Store DM$ document payloads, one transaction each as policy relays a single OP_RETURN output
+     * per transaction. Coins are listed once, every confirmed coin funds a chain of documents through
+     * its change, limited by the mempool ancestor and descendant limits. The locks are held per document.
+     * @note vTxidRet receives the committed transactions in payload order, also when it fails half way
+     * @note fInsufficientFundsRet tells a lack of confirmed coins apart from other failures
+     */
+    bool StoreDocuments(const std::vector<std::vector<unsigned char> >& vPayloads, std::vector<uint256>& vTxidRet, CConnman* connman,
+                        std::string& strFailReason, bool& fInsufficientFundsRet);
+
     bool CreateCollateralTransaction(CMutableTransaction& txCollateral, std::string& strReason);
     bool ConvertList(std::vector<CTxIn> vecTxIn, std::vector<CAmount>& vecAmounts);
 
@@ -40,3 +40,8 @@ bool CZMQAbstractNotifier::NotifyInstantSendDoubleSpendAttempt(const CTransactio
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyDocument(const CTransaction& /*transaction*/, unsigned int /*nOut*/, int /*nHeight*/)
+{
+    return true;
+}
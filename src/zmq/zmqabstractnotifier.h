@@ -40,6 +40,8 @@ public:
     virtual bool NotifyGovernanceVote(const CGovernanceVote &vote);
     virtual bool NotifyGovernanceObject(const CGovernanceObject &object);
     virtual bool NotifyInstantSendDoubleSpendAttempt(const CTransaction &currentTx, const CTransaction &previousTx);
+    // nHeight is -1 while the document is unconfirmed
+    virtual bool NotifyDocument(const CTransaction &transaction, unsigned int nOut, int nHeight);
 
 
 protected:
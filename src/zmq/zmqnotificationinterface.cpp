@@ -6,6 +6,8 @@
 #include "zmqpublishnotifier.h"
 
 #include "version.h"
+#include "primitives/document.h"
+#include "txmempool.h"
 #include "validation.h"
 #include "streams.h"
 #include "util.h"
@@ -41,12 +43,14 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashgovernancevote"] = CZMQAbstractNotifier::Create<CZMQPublishHashGovernanceVoteNotifier>;
     factories["pubhashgovernanceobject"] = CZMQAbstractNotifier::Create<CZMQPublishHashGovernanceObjectNotifier>;
     factories["pubhashinstantsenddoublespend"] = CZMQAbstractNotifier::Create<CZMQPublishHashInstantSendDoubleSpendNotifier>;
+    factories["pubhashdocument"] = CZMQAbstractNotifier::Create<CZMQPublishHashDocumentNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
     factories["pubrawgovernancevote"] = CZMQAbstractNotifier::Create<CZMQPublishRawGovernanceVoteNotifier>;
     factories["pubrawgovernanceobject"] = CZMQAbstractNotifier::Create<CZMQPublishRawGovernanceObjectNotifier>;
     factories["pubrawinstantsenddoublespend"] = CZMQAbstractNotifier::Create<CZMQPublishRawInstantSendDoubleSpendNotifier>;
+    factories["pubrawdocument"] = CZMQAbstractNotifier::Create<CZMQPublishRawDocumentNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i)
     {
@@ -167,6 +171,32 @@ void CZMQNotificationInterface::SyncTransaction(const CTransaction& tx, const CB
             i = notifiers.erase(i);
         }
     }
+
+    // documents that entered a block or the mempool, not conflicted or disconnected ones
+    int nHeight = posInBlock == CMainSignals::SYNC_TRANSACTION_NOT_IN_BLOCK ? -1 : pindex->nHeight;
+    if (nHeight < 0 && !mempool.exists(tx.GetHash()))
+        return;
+
+    for (unsigned int nOut = 0; nOut < tx.vout.size(); nOut++)
+    {
+        CDocumentRef document;
+        if (!tx.vout[nOut].GetDocumentRef(document))
+            continue;
+
+        for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+        {
+            CZMQAbstractNotifier *notifier = *i;
+            if (notifier->NotifyDocument(tx, nOut, nHeight))
+            {
+                i++;
+            }
+            else
+            {
+                notifier->Shutdown();
+                i = notifiers.erase(i);
+            }
+        }
+    }
 }
 
 void CZMQNotificationInterface::NotifyTransactionLock(const CTransaction &tx)
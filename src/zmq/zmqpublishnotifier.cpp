@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "primitives/document.h"
 #include "streams.h"
 #include "zmqpublishnotifier.h"
 #include "validation.h"
@@ -16,12 +17,14 @@ static const char *MSG_HASHTXLOCK = "hashtxlock";
 static const char *MSG_HASHGVOTE  = "hashgovernancevote";
 static const char *MSG_HASHGOBJ   = "hashgovernanceobject";
 static const char *MSG_HASHISCON  = "hashinstantsenddoublespend";
+static const char *MSG_HASHDOC    = "hashdocument";
 static const char *MSG_RAWBLOCK   = "rawblock";
 static const char *MSG_RAWTX      = "rawtx";
 static const char *MSG_RAWTXLOCK  = "rawtxlock";
 static const char *MSG_RAWGVOTE   = "rawgovernancevote";
 static const char *MSG_RAWGOBJ    = "rawgovernanceobject";
 static const char *MSG_RAWISCON   = "rawinstantsenddoublespend";
+static const char *MSG_RAWDOC     = "rawdocument";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -279,3 +282,35 @@ bool CZMQPublishRawInstantSendDoubleSpendNotifier::NotifyInstantSendDoubleSpendA
     return SendMessage(MSG_RAWISCON, &(*ssCurrent.begin()), ssCurrent.size())
         && SendMessage(MSG_RAWISCON, &(*ssPrevious.begin()), ssPrevious.size());
 }
+
+// Transaction hash (32 bytes, reversed as in hashtx), output index and block height (4 bytes little endian each)
+static void DocumentHeader(const CTransaction &transaction, unsigned int nOut, int nHeight, std::vector<unsigned char>& data)
+{
+    uint256 hash = transaction.GetHash();
+    data.assign(hash.begin(), hash.end());
+    std::reverse(data.begin(), data.end());
+    for (int i = 0; i < 4; i++)
+        data.push_back(nOut >> (8 * i));
+    for (int i = 0; i < 4; i++)
+        data.push_back((uint32_t)nHeight >> (8 * i));
+}
+
+bool CZMQPublishHashDocumentNotifier::NotifyDocument(const CTransaction &transaction, unsigned int nOut, int nHeight)
+{
+    LogPrint("zmq", "zmq: Publish hashdocument %s:%u at height %d\n", transaction.GetHash().GetHex(), nOut, nHeight);
+    std::vector<unsigned char> data;
+    DocumentHeader(transaction, nOut, nHeight, data);
+    return SendMessage(MSG_HASHDOC, data.data(), data.size());
+}
+
+bool CZMQPublishRawDocumentNotifier::NotifyDocument(const CTransaction &transaction, unsigned int nOut, int nHeight)
+{
+    LogPrint("zmq", "zmq: Publish rawdocument %s:%u at height %d\n", transaction.GetHash().GetHex(), nOut, nHeight);
+    CDocumentRef document;
+    if (!transaction.vout[nOut].GetDocumentRef(document))
+        return true;
+    std::vector<unsigned char> data;
+    DocumentHeader(transaction, nOut, nHeight, data);
+    data.insert(data.end(), document.pbegin, document.pend);
+    return SendMessage(MSG_RAWDOC, data.data(), data.size());
+}
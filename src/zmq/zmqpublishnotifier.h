@@ -66,6 +66,12 @@ public:
     bool NotifyInstantSendDoubleSpendAttempt(const CTransaction &currentTx, const CTransaction &previousTx) override;
 };
 
+class CZMQPublishHashDocumentNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyDocument(const CTransaction &transaction, unsigned int nOut, int nHeight) override;
+};
+
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
@@ -101,4 +107,10 @@ class CZMQPublishRawInstantSendDoubleSpendNotifier : public CZMQAbstractPublishN
 public:
     bool NotifyInstantSendDoubleSpendAttempt(const CTransaction &currentTx, const CTransaction &previousTx) override;
 };
+class CZMQPublishRawDocumentNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyDocument(const CTransaction &transaction, unsigned int nOut, int nHeight) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H